@@ -0,0 +1,110 @@
+/** @file autoscript.h
+ * @brief Header file for the autonomous script interpreter
+ *
+ * An autonomous routine is a compact bytecode: each instruction is one opcode byte followed by
+ * its 16-bit little-endian arguments. Scripts are either compiled in with the SCRIPT_ macros
+ * below or read from the Cortex file system. The interpreter is stepped once per scheduler tick
+ * and runs instructions until one has to wait.
+ *
+ * Outside a parallel group, a motion instruction waits for its primitive to finish before the
+ * next instruction starts. Between SCRIPT_PARALLEL() and SCRIPT_JOIN(), motion instructions
+ * start back to back, and SCRIPT_JOIN() waits for all of them.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef AUTOSCRIPT_H_
+#define AUTOSCRIPT_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest script that can be loaded from a file
+#define SCRIPT_MAX_BYTES 512
+// Most instructions run in one tick, so a script without waits can't stall the scheduler
+#define SCRIPT_MAX_STEPS_PER_TICK 16
+
+// Opcodes and their arguments
+// End of the script
+#define OP_END 0x00
+// ticks, max speed, timeout ms
+#define OP_DRIVE 0x01
+// heading, timeout ms
+#define OP_TURN 0x02
+// upper lift position in thousandths of full travel, timeout ms
+#define OP_LIFT 0x03
+// speed, duration ms
+#define OP_LOWER_LIFT 0x04
+// duration ms
+#define OP_WAIT 0x05
+// Start a parallel group
+#define OP_PARALLEL 0x06
+// End a parallel group, waiting for everything started in it
+#define OP_JOIN 0x07
+// offset: continue that many bytes after the end of this instruction
+#define OP_JUMP 0x08
+// digital pin, level, offset: jump if the pin reads the level, debounced if the pin is watched.
+// Pins outside 1 to SENSOR_DIGITAL_PINS end the script.
+#define OP_JUMP_IF_DIGITAL 0x09
+
+// Bytes taken by each instruction, for working out jump offsets
+#define SCRIPT_SIZE_DRIVE 7
+#define SCRIPT_SIZE_TURN 5
+#define SCRIPT_SIZE_LIFT 5
+#define SCRIPT_SIZE_LOWER_LIFT 5
+#define SCRIPT_SIZE_WAIT 3
+#define SCRIPT_SIZE_JUMP 3
+
+// Encodes a 16-bit argument
+#define SCRIPT_ARG(value) ((value) & 0xFF), (((value) >> 8) & 0xFF)
+
+#define SCRIPT_END() OP_END
+#define SCRIPT_DRIVE(ticks, maxSpeed, timeoutMs) \
+    OP_DRIVE, SCRIPT_ARG(ticks), SCRIPT_ARG(maxSpeed), SCRIPT_ARG(timeoutMs)
+#define SCRIPT_TURN(heading, timeoutMs) OP_TURN, SCRIPT_ARG(heading), SCRIPT_ARG(timeoutMs)
+#define SCRIPT_LIFT(thousandths, timeoutMs) \
+    OP_LIFT, SCRIPT_ARG(thousandths), SCRIPT_ARG(timeoutMs)
+#define SCRIPT_LOWER_LIFT(speed, durationMs) \
+    OP_LOWER_LIFT, SCRIPT_ARG(speed), SCRIPT_ARG(durationMs)
+#define SCRIPT_WAIT(durationMs) OP_WAIT, SCRIPT_ARG(durationMs)
+#define SCRIPT_PARALLEL() OP_PARALLEL
+#define SCRIPT_JOIN() OP_JOIN
+#define SCRIPT_JUMP(offset) OP_JUMP, SCRIPT_ARG(offset)
+#define SCRIPT_JUMP_IF_DIGITAL(pin, level, offset) \
+    OP_JUMP_IF_DIGITAL, SCRIPT_ARG(pin), SCRIPT_ARG(level), SCRIPT_ARG(offset)
+
+/**
+ * Starts running a compiled-in script from the beginning. The script is not copied.
+ *
+ * @param code the bytecode
+ * @param length the number of bytes of bytecode
+ */
+void scriptLoad(const unsigned char *code, int length);
+/**
+ * Reads a script from the Cortex file system without running it. Reading flash is slow, so do
+ * it before the match and pass the buffer to scriptLoad() when the routine starts.
+ *
+ * @param name the file name
+ * @param buffer filled in with the script, SCRIPT_MAX_BYTES long
+ * @return the number of bytes read, 0 if the file does not exist or is empty
+ */
+int scriptReadFile(const char *name, unsigned char *buffer);
+/**
+ * Runs instructions until one has to wait or the script ends. Register with the scheduler
+ * before motionUpdate().
+ */
+void scriptStep();
+/**
+ * Returns true until the script reaches its end or an invalid instruction.
+ */
+bool scriptIsRunning();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+/** @file blackbox.h
+ * @brief Header file for the black box match recorder
+ *
+ * blackboxRecord() runs at the end of every control tick and copies the sensor frame, the motor
+ * frame, the competition state and both battery levels into a RAM ring holding the last
+ * BLACKBOX_SAMPLES samples, about six seconds. That is all the control task ever does; nothing is
+ * encoded or written while the robot is enabled, since PROS stalls user tasks during file writes
+ * and asks for them to happen only with the motors stopped.
+ *
+ * Samples are only taken while the robot is enabled. A background task watches for the robot
+ * being disabled and then writes the ring to a file named after the mode that ended,
+ * BLACKBOX_AUTO_FILE or BLACKBOX_DRIVE_FILE. A fault, such as a scheduler overrun, a low battery
+ * or a motion primitive timing out, keeps recording for half the ring and then freezes it, so the
+ * ring holds the seconds around the fault. It is written at the next disable to
+ * BLACKBOX_FAULT_FILE, where later matches without faults won't overwrite it.
+ *
+ * File format, all little-endian: 'B', 'B', BLACKBOX_VERSION, the reason it was written, the
+ * sample period in milliseconds, the number of samples in 16 bits and the number of fields per
+ * sample. Each sample then has a 3 byte mask of the fields that changed since the one before,
+ * starting from all zero, followed by the change of each of those fields as a zigzag varint.
+ * Fields, in order: time in ms, analog channels 1 to 4, digital pins, both IMEs, gyro, motor
+ * frame ports 1 to 10, competition state, main battery mV and backup battery mV. Most samples
+ * take under ten bytes, and even the worst case fits in the file size given by
+ * BLACKBOX_MAX_FILE_BYTES. tools/blackbox decodes a file into CSV.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef BLACKBOX_H_
+#define BLACKBOX_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLACKBOX_VERSION 1
+// Samples kept in RAM, and control ticks per sample
+#define BLACKBOX_SAMPLES 150
+#define BLACKBOX_TICKS_PER_SAMPLE 2
+// Analog channels recorded, starting from 1
+#define BLACKBOX_ANALOG 4
+#define BLACKBOX_FIELDS (1 + BLACKBOX_ANALOG + 1 + 2 + 1 + 10 + 1 + 2)
+#define BLACKBOX_HEADER_BYTES 8
+// A 3 byte mask and a 5 byte varint for every field
+#define BLACKBOX_MAX_SAMPLE_BYTES (3 + 5 * BLACKBOX_FIELDS)
+#define BLACKBOX_MAX_FILE_BYTES \
+    (BLACKBOX_HEADER_BYTES + BLACKBOX_SAMPLES * BLACKBOX_MAX_SAMPLE_BYTES)
+
+#define BLACKBOX_AUTO_FILE "bbauto"
+#define BLACKBOX_DRIVE_FILE "bbdrive"
+#define BLACKBOX_FAULT_FILE "bbfault"
+
+// How often the background task checks for the robot being disabled, in milliseconds
+#define BLACKBOX_WATCH_MS 50
+#define BLACKBOX_TASK_PRIORITY (TASK_PRIORITY_DEFAULT - 1)
+// Main battery level that counts as a fault, in millivolts
+#define BLACKBOX_LOW_BATTERY_MV 6000
+
+// Bits of the competition state field
+#define BLACKBOX_ENABLED 1
+#define BLACKBOX_AUTONOMOUS 2
+#define BLACKBOX_ONLINE 4
+// The scheduler skipped low priority callbacks that tick
+#define BLACKBOX_DEGRADED 8
+
+// Why a recording was written
+typedef enum {
+    BLACKBOX_REASON_DISABLED = 0,
+    BLACKBOX_REASON_OVERRUN,
+    BLACKBOX_REASON_LOW_BATTERY,
+    BLACKBOX_REASON_TIMEOUT,
+} BlackboxReason;
+
+/**
+ * Starts the task that writes the ring out when the robot is disabled. Only the first call does
+ * anything.
+ */
+void blackboxStart();
+/**
+ * Adds a sample to the ring every BLACKBOX_TICKS_PER_SAMPLE calls, and checks for the faults
+ * it can see itself. Register this after motorFrameFlush().
+ */
+void blackboxRecord();
+/**
+ * Reports a fault, so the seconds around it are kept and written to BLACKBOX_FAULT_FILE. Only
+ * the first fault between two disables counts.
+ */
+void blackboxFault(BlackboxReason reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
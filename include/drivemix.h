@@ -0,0 +1,61 @@
+/** @file drivemix.h
+ * @brief Header file for the drive mixer
+ *
+ * Turns two driver inputs into left and right drive powers, and writes them to the motor frame.
+ *
+ * Tank drive runs each side from its own input. Arcade drive takes a throttle and a turn, adding
+ * the turn to the left side and taking it from the right. Curvature drive does the same, but
+ * scales the turn by the throttle, so the stick sets how tight an arc to drive rather than how
+ * fast to spin, and the robot steers the same at any speed. Below DRIVE_QUICK_TURN_THROTTLE the
+ * turn blends towards arcade drive's, reaching turning in place at zero throttle, so the robot can
+ * still spin without lurching between a spin and an arc as the throttle crosses the threshold.
+ *
+ * When a side would need more than full power, both sides are scaled down by the same factor.
+ * The ratio between the sides is kept, so a full throttle turn still turns instead of being
+ * clipped into driving straight.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef DRIVEMIX_H_
+#define DRIVEMIX_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Throttle below which curvature drive blends into turning in place
+#define DRIVE_QUICK_TURN_THROTTLE 32
+
+typedef enum {
+    // first is the left side, second the right
+    DRIVE_TANK = 0,
+    // first is the throttle, second the turn, positive turning clockwise
+    DRIVE_ARCADE,
+    // first is the throttle, second the curvature, positive turning clockwise
+    DRIVE_CURVATURE,
+} DriveMode;
+
+/**
+ * Mixes two inputs into drive powers, each from -127 to 127.
+ *
+ * @param mode how to mix the inputs
+ * @param first the first input, from -127 to 127
+ * @param second the second input, from -127 to 127
+ * @param left filled in with the left side's power
+ * @param right filled in with the right side's power
+ */
+void driveMix(DriveMode mode, int first, int second, int *left, int *right);
+/**
+ * Mixes two inputs with driveMix() and writes the powers to the motor frame.
+ */
+void driveMixSet(DriveMode mode, int first, int second);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/** @file events.h
+ * @brief Header file for interrupt-driven digital input events
+ *
+ * Watched digital pins raise an interrupt on every edge. The handler only stamps the edge with
+ * micros() and the level it left the pin at, and pushes it onto a queue; it is the only writer of
+ * the queue's head and eventsDispatch() is the only writer of its tail, so neither side ever
+ * waits. eventsDispatch() runs at the start of each control tick, debounces the edges, updates
+ * each pin's level, edge counts and last change time, and calls the pin's callback for every
+ * change it accepts. Changes carry the time the edge actually happened, to the microsecond, even
+ * though they are handled at the next tick.
+ *
+ * An edge is accepted when it changes the pin's level and comes at least the pin's debounce time
+ * after the last accepted change, so the bounces right after a switch closes are ignored. If the
+ * pin settles at a different level than the last accepted one, the next dispatch notices and
+ * accepts that too.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Edges the queue holds between two dispatches, a power of two
+#define EVENT_QUEUE_SIZE 32
+// Debounce time of a VEX limit switch or bumper, in microseconds
+#define EVENT_DEBOUNCE_US 5000
+
+/**
+ * Called from eventsDispatch() when a pin's level changes.
+ *
+ * @param pin the pin that changed
+ * @param level the new level, true being HIGH
+ * @param time micros() when the edge happened
+ */
+typedef void (*EventCallback)(unsigned char pin, bool level, unsigned long time);
+
+/**
+ * Starts watching a digital input pin for changes.
+ *
+ * @param pin the pin, 1 to 9 or 11 to 12, set up as an input
+ * @param debounceUs how long after a change to ignore further edges, in microseconds
+ * @return false if the pin can't raise interrupts
+ */
+bool eventsWatch(unsigned char pin, unsigned long debounceUs);
+/**
+ * Sets the function called for every accepted change of a watched pin, or NULL for none.
+ */
+void eventsOnChange(unsigned char pin, EventCallback callback);
+/**
+ * Handles every queued edge. Register this as one of the first callbacks of the tick.
+ */
+void eventsDispatch();
+/**
+ * Returns true if eventsWatch() has been called for a pin.
+ */
+bool eventsIsWatched(unsigned char pin);
+/**
+ * Returns the debounced level of a watched pin, true being HIGH.
+ */
+bool eventsLevel(unsigned char pin);
+/**
+ * Returns the number of accepted LOW to HIGH changes of a watched pin since it was watched.
+ */
+unsigned long eventsRisingCount(unsigned char pin);
+/**
+ * Returns the number of accepted HIGH to LOW changes of a watched pin since it was watched.
+ */
+unsigned long eventsFallingCount(unsigned char pin);
+/**
+ * Returns micros() at the last accepted change of a watched pin, or when it started being
+ * watched.
+ */
+unsigned long eventsLastChange(unsigned char pin);
+/**
+ * Returns the number of edges lost because the queue was full.
+ */
+unsigned long eventsDropped();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
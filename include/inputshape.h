@@ -0,0 +1,125 @@
+/** @file inputshape.h
+ * @brief Header file for joystick input shaping
+ *
+ * Every joystick axis goes through a 256-entry table, indexed by the raw value plus 128, that
+ * gives the motor power for it. Shaping an axis is then one table lookup per tick, whatever the
+ * curve. The tables are generated by the compiler from the curve macros below, so they cost no
+ * RAM and no time at startup.
+ *
+ * Every curve has a deadband, inside which the axis reads 0, and stretches the rest of the throw
+ * back out to the full range so there is no jump in power just past it. The cubic and quintic
+ * curves blend in a percentage of the axis cubed or to the fifth, which leaves more of the stick
+ * for fine control at low speeds while still reaching full power.
+ *
+ * A driver profile picks a table for each axis of both joysticks. The profile can be changed from
+ * the LCD while the robot is disabled, with the left and right buttons, and the choice is saved to
+ * INPUT_SHAPE_FILE so it survives a reset. While the potentiometer calibration is flagged as
+ * SENSOR_CALIBRATION_MISMATCH, the menu says so, and the center button, pressed with the lift
+ * resting at the bottom, has the offsets measured again.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef INPUTSHAPE_H_
+#define INPUTSHAPE_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Table entries, one for every value of a signed char
+#define INPUT_SHAPE_ENTRIES 256
+// Axes shaped, 1 to 4 of the main and then the partner joystick
+#define INPUT_SHAPE_AXES 8
+#define INPUT_SHAPE_FILE "shape"
+// How often the LCD menu checks its buttons while the robot is disabled, in milliseconds
+#define INPUT_SHAPE_LCD_MS 50
+#define INPUT_SHAPE_TASK_PRIORITY (TASK_PRIORITY_DEFAULT - 1)
+
+// An axis value from -127 to 127, treating -128 as -127
+#define shapeClamp(x) ((x) < -127 ? -127 : (x))
+#define shapeMagnitude(x) (shapeClamp(x) < 0 ? -shapeClamp(x) : shapeClamp(x))
+#define shapeSign(x) ((x) < 0 ? -1 : 1)
+// Magnitude past a deadband, stretched back out to 0 to 127
+#define shapeStretch(x, deadband) (shapeMagnitude(x) <= (deadband) ? 0 : \
+    (shapeMagnitude(x) - (deadband)) * 127 / (127 - (deadband)))
+
+/*
+ * Curves, each giving the power for an axis value x. weight is the percentage of the curve's
+ * power term, the rest being linear; linear curves ignore it.
+ */
+#define SHAPE_LINEAR(x, deadband, weight) (shapeSign(x) * shapeStretch(x, deadband))
+#define SHAPE_CUBIC(x, deadband, weight) (shapeSign(x) * \
+    ((weight) * (shapeStretch(x, deadband) * shapeStretch(x, deadband) / 127 * \
+    shapeStretch(x, deadband) / 127) + (100 - (weight)) * shapeStretch(x, deadband)) / 100)
+#define SHAPE_QUINTIC(x, deadband, weight) (shapeSign(x) * \
+    ((weight) * (shapeStretch(x, deadband) * shapeStretch(x, deadband) / 127 * \
+    shapeStretch(x, deadband) / 127 * shapeStretch(x, deadband) / 127 * \
+    shapeStretch(x, deadband) / 127) + (100 - (weight)) * shapeStretch(x, deadband)) / 100)
+
+// Table entries for x from i up, in blocks of 4, 16 and 64
+#define SHAPE_ENTRIES_4(curve, i, deadband, weight) curve((i), deadband, weight), \
+    curve((i) + 1, deadband, weight), curve((i) + 2, deadband, weight), \
+    curve((i) + 3, deadband, weight),
+#define SHAPE_ENTRIES_16(curve, i, deadband, weight) \
+    SHAPE_ENTRIES_4(curve, i, deadband, weight) \
+    SHAPE_ENTRIES_4(curve, (i) + 4, deadband, weight) \
+    SHAPE_ENTRIES_4(curve, (i) + 8, deadband, weight) \
+    SHAPE_ENTRIES_4(curve, (i) + 12, deadband, weight)
+#define SHAPE_ENTRIES_64(curve, i, deadband, weight) \
+    SHAPE_ENTRIES_16(curve, i, deadband, weight) \
+    SHAPE_ENTRIES_16(curve, (i) + 16, deadband, weight) \
+    SHAPE_ENTRIES_16(curve, (i) + 32, deadband, weight) \
+    SHAPE_ENTRIES_16(curve, (i) + 48, deadband, weight)
+
+/**
+ * Initializer of a table for a curve, entry 0 being x = -128.
+ *
+ * @param curve SHAPE_LINEAR, SHAPE_CUBIC or SHAPE_QUINTIC
+ * @param deadband how far the axis can move from center and still read 0
+ * @param weight the percentage of the curve's power term
+ */
+#define SHAPE_TABLE(curve, deadband, weight) { \
+    SHAPE_ENTRIES_64(curve, -128, deadband, weight) \
+    SHAPE_ENTRIES_64(curve, -64, deadband, weight) \
+    SHAPE_ENTRIES_64(curve, 0, deadband, weight) \
+    SHAPE_ENTRIES_64(curve, 64, deadband, weight) }
+
+typedef signed char ShapeTable[INPUT_SHAPE_ENTRIES];
+
+typedef struct {
+    // Up to 12 characters, to fit the LCD menu
+    const char *name;
+    // Table of each axis, 1 to 4 of the main and then the partner joystick
+    const signed char *axes[INPUT_SHAPE_AXES];
+} InputProfile;
+
+extern const InputProfile inputProfiles[];
+extern const int inputProfileCount;
+
+/**
+ * Loads the saved profile and starts the task that runs the LCD menu while the robot is
+ * disabled. Call once from initialize() after lcdInit().
+ *
+ * @param lcdPort the LCD, either uart1 or uart2
+ */
+void inputShapeStart(PROS_FILE *lcdPort);
+/**
+ * Returns an analog axis as of the start of this tick, like joyAnalog(), shaped by the selected
+ * profile.
+ */
+int inputShapeAxis(unsigned char joystick, unsigned char axis);
+/**
+ * Selects a profile, by its index in inputProfiles.
+ */
+void inputShapeSelect(int profile);
+int inputShapeSelected();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
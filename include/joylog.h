@@ -0,0 +1,83 @@
+/** @file joylog.h
+ * @brief Header file for the joystick input recorder and player
+ *
+ * Driver control reads the joysticks through joyAnalog() and joyDigital(), which return the state
+ * joylogUpdate() took at the start of the tick. That state comes from the real joysticks, or from
+ * a log being replayed, and can be recorded to a stream at the same time. Every callback in a
+ * tick sees the same inputs, and a replayed log produces the exact inputs the driver gave.
+ *
+ * A log starts with a 4 byte header: 'J', 'L', JOYLOG_VERSION and the tick period in
+ * milliseconds. After that, each record covers one or more ticks:
+ *   1xxxxxxx            the inputs stayed the same for the next x ticks (1 to 127)
+ *   0000mmmm mmmmmmmm   the fields with their bit set in the 12 bit mask m changed this tick,
+ *                       followed by the new value of each, in field order
+ * Fields 0 to 3 are axes 1 to 4 of the main joystick and 4 to 7 those of the partner joystick.
+ * Fields 8 and 9 hold the main joystick's button groups, 5 and 7 in the low nibbles and 6 and 8
+ * in the high nibbles, as JOY_DOWN | JOY_LEFT | JOY_UP | JOY_RIGHT masks, and fields 10 and 11
+ * those of the partner joystick. A tick with no stick movement costs nothing until the run is
+ * written out, so a two minute match usually records in a few kilobytes.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef JOYLOG_H_
+#define JOYLOG_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JOYLOG_VERSION 1
+// Bytes of joystick state recorded per tick
+#define JOYLOG_FIELDS 12
+// Longest run of unchanged ticks one byte can record
+#define JOYLOG_MAX_RUN 127
+
+/**
+ * Takes this tick's joystick state, from the joysticks or the log being replayed, and records it
+ * if recording. Register this as the first callback of the tick.
+ */
+void joylogUpdate();
+/**
+ * Returns an analog axis as of the start of this tick, like joystickGetAnalog().
+ */
+int joyAnalog(unsigned char joystick, unsigned char axis);
+/**
+ * Returns a button as of the start of this tick, like joystickGetDigital().
+ */
+bool joyDigital(unsigned char joystick, unsigned char buttonGroup, unsigned char button);
+/**
+ * Starts recording the joystick state of every tick to a stream. Use a serial port while the
+ * robot is driving, since PROS asks for files to be written only with the motors stopped.
+ *
+ * @param stream an open file in Write mode, or uart1 or uart2 after usartInit()
+ * @param periodMs the tick period, stored in the header
+ */
+void joylogRecord(PROS_FILE *stream, unsigned char periodMs);
+/**
+ * Starts taking the joystick state from a log instead of the joysticks. When the log ends, the
+ * joysticks read as released until joylogStop() is called.
+ *
+ * @param stream an open file in Read mode, or a serial port, positioned at the header
+ * @return true if the header was valid
+ */
+bool joylogReplay(PROS_FILE *stream);
+/**
+ * Stops recording or replaying, writing out any pending run, and goes back to the joysticks.
+ * Files are closed; serial ports are left open.
+ */
+void joylogStop();
+bool joylogIsRecording();
+/**
+ * Returns true until a replayed log runs out.
+ */
+bool joylogIsReplaying();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
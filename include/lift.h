@@ -0,0 +1,84 @@
+/** @file lift.h
+ * @brief Header file for the upper lift
+ *
+ * The two sides of the upper lift are kept level by cross-coupling: a PID controller on the
+ * difference between the two potentiometers speeds up the lower side and slows the higher side
+ * by the same amount. If that pushes either side past full speed, both are shifted back together
+ * so the difference is kept and the lagging side runs at full speed.
+ *
+ * Presets are the heights the lift is most often needed at: the bottom, the loader and each
+ * stacking height. motionLiftTo() takes the lift to one under closed-loop control while the driver
+ * keeps driving everything else.
+ *
+ * Left alone, a loaded lift sags. liftHold() latches the height the lift is at when it is first
+ * called and holds it there, with a feedforward for the lift's weight at that height and a small
+ * PID correction on top. The hold power is capped well below full power, since a held lift is
+ * stalled and would otherwise overheat its motors. Near the bottom the lift just rests on its
+ * hard stop.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef LIFT_H_
+#define LIFT_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Preset heights, as Q16 potentiometer positions
+#define LIFT_BOTTOM 0
+#define LIFT_LOADER (POTENT_ONE * 3 / 10)
+#define LIFT_STACK_HEIGHTS 5
+// How far past a stacking height the lift has to be to count as having passed it
+#define LIFT_PRESET_MARGIN (POTENT_ONE / 25)
+// Longest a move to a preset may take, in milliseconds
+#define LIFT_PRESET_TIMEOUT 3000
+
+// Feedforward holding the lift up at each quarter of its travel, from the bottom to the top
+#define LIFT_HOLD_POINTS 5
+// Most power the hold may use, so stalled motors don't overheat
+#define LIFT_HOLD_LIMIT 40
+// Below this the lift is left resting on its hard stop
+#define LIFT_HOLD_FLOOR (POTENT_ONE / 50)
+
+// Stacking heights, lowest first
+extern const int liftStackHeights[LIFT_STACK_HEIGHTS];
+
+/**
+ * Resets the lift controllers. Call once before the control loop starts.
+ */
+void liftInit();
+/**
+ * Returns the lift's height, the average of both sides' Q16 potentiometer positions.
+ */
+int liftPosition();
+/**
+ * Returns the lowest stacking height above a position, or the highest one if there is none.
+ */
+int liftStackAbove(int position);
+/**
+ * Returns the highest stacking height below a position, or the lowest one if there is none.
+ */
+int liftStackBelow(int position);
+/**
+ * Runs both sides of the upper lift at a common speed while keeping them level. Call once per
+ * scheduler tick after setPotents().
+ *
+ * @param speed the speed for both sides, positive raising the lift
+ */
+void liftDrive(int speed);
+/**
+ * Holds the upper lift where it was the first time this was called since liftDrive(). Call once
+ * per scheduler tick after setPotents(), instead of liftDrive(0).
+ */
+void liftHold();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,6 +18,12 @@
 // Analog
 #define LEFT_POTENT 1
 #define RIGHT_POTENT 2
+#define GYRO_PORT 3
+// I2C IME addresses, in order along the chain from the Cortex
+#define L_DRIVE_IME 0
+#define R_DRIVE_IME 1
+// UART 1 is left free for streaming joystick logs
+#define LCD_PORT uart2
 
 /** @file main.h
  * @brief Header file for global functions
@@ -47,6 +53,23 @@
 #define MAIN_H_
 
 #include <API.h>
+#include "profiler.h"
+#include "scheduler.h"
+#include "runtime.h"
+#include "telemetry.h"
+#include "blackbox.h"
+#include "events.h"
+#include "motors.h"
+#include "drivemix.h"
+#include "sensors.h"
+#include "odometry.h"
+#include "pid.h"
+#include "lift.h"
+#include "motionprofile.h"
+#include "motion.h"
+#include "autoscript.h"
+#include "joylog.h"
+#include "inputshape.h"
 
 // Allow usage of this file in C++ programs
 #ifdef __cplusplus
@@ -73,6 +96,14 @@ extern "C" {
  * so, the robot will await a switch to another mode or disable/enable cycle.
  */
 void autonomous();
+/**
+ * Reads the autonomous script from the file system, if there is one, so autonomous can start it
+ * without reading flash on its first tick. Call once from initialize().
+ */
+void autonomousPrepare();
+// What the runtime runs during autonomous, and during driver control
+extern const Behavior autonomousBehavior;
+extern const Behavior driverControlBehavior;
 /**
  * Runs pre-initialization code. This function will be started in kernel mode one time while the
  * VEX Cortex is starting up. As the scheduler is still paused, most API functions will fail.
@@ -116,9 +147,16 @@ void initialize();
 void operatorControl();
 
 // Potent, added manually
+// Potentiometer positions are Q16 fixed point: 0 is the bottom, POTENT_ONE the top
+#define POTENT_ONE 65536
+// Converts a Q16 position to thousandths, for printing without floats
+#define potentToMilli(q16) (((q16) * 1000) >> 16)
+
 void setPotents();
-float getLeftPotent();
-float getRightPotent();
+int getLeftPotentQ16();
+int getRightPotentQ16();
+int getLeftPotentRateQ16();
+int getRightPotentRateQ16();
 
 int getLeftPotentRaw();
 int getRightPotentRaw();
@@ -0,0 +1,104 @@
+/** @file motion.h
+ * @brief Header file for the non-blocking autonomous motion primitives
+ *
+ * Each motion channel (the drive, the upper lift and the lower lift) runs at most one primitive
+ * at a time. Starting a primitive returns immediately, and motionUpdate() advances every running
+ * primitive once per scheduler tick, so primitives on different channels run at the same time.
+ * A primitive finishes when its sensor has stayed within tolerance of the target for a few ticks,
+ * or times out, and either way its motors are stopped.
+ *
+ * Drive and upper lift moves follow an S-curve motion profile from motionprofile.h: the velocity
+ * the profile calls for is fed forward, and a PID controller corrects the position error against
+ * where the profile says the move should be by now.
+ *
+ * The lower lift has no position sensor, so its primitive runs for a set time instead, with its
+ * power ramped up and down along a profile.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef MOTION_H_
+#define MOTION_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MOTION_DRIVE = 0,
+    MOTION_UPPER_LIFT,
+    MOTION_LOWER_LIFT,
+    MOTION_CHANNELS,
+} MotionChannel;
+
+typedef enum {
+    // Nothing has been started on the channel since motionInit()
+    MOTION_IDLE = 0,
+    MOTION_RUNNING,
+    // Reached the target
+    MOTION_DONE,
+    // Ran out of time before reaching the target, or was stopped
+    MOTION_TIMEOUT,
+} MotionState;
+
+/**
+ * Stops every channel and resets it to MOTION_IDLE.
+ */
+void motionInit();
+/**
+ * Drives straight for a distance, holding the heading the robot had when the move started.
+ *
+ * @param ticks the distance in drive IME ticks, negative to drive backwards
+ * @param maxSpeed the fastest the drive may run, up to 127 for the fastest profiled speed
+ * @param timeoutMs the longest the move may take
+ */
+void motionDriveDistance(int ticks, int maxSpeed, unsigned long timeoutMs);
+/**
+ * Turns in place to a gyro heading.
+ *
+ * @param heading the target heading in degrees, as reported by gyroGet(), counterclockwise being
+ * positive
+ * @param timeoutMs the longest the turn may take
+ */
+void motionTurnTo(int heading, unsigned long timeoutMs);
+/**
+ * Moves the upper lift to a position, keeping both sides level.
+ *
+ * @param position the Q16 potentiometer position, 0 to POTENT_ONE
+ * @param timeoutMs the longest the move may take
+ */
+void motionLiftTo(int position, unsigned long timeoutMs);
+/**
+ * Runs the lower lift at a speed for about a time. The power ramps up and down, and the
+ * primitive runs on a little longer to make up for the ramps.
+ *
+ * @param speed the lower lift speed, positive raising it
+ * @param durationMs how long running at the speed the whole time would take
+ */
+void motionLowerLiftFor(int speed, unsigned long durationMs);
+/**
+ * Stops whatever is running on a channel. Its state becomes MOTION_TIMEOUT if it was running.
+ */
+void motionStop(MotionChannel channel);
+/**
+ * Returns the state of a channel.
+ */
+MotionState motionGetState(MotionChannel channel);
+/**
+ * Returns true if a primitive is running on the channel.
+ */
+bool motionIsBusy(MotionChannel channel);
+/**
+ * Advances every running primitive and writes its motors into the motor frame. Register with
+ * the scheduler after setPotents() and before motorFrameFlush().
+ */
+void motionUpdate();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+/** @file motionprofile.h
+ * @brief Header file for the motion profile generator
+ *
+ * A profile plans a move of a set distance so the velocity ramps up to a cruising speed, holds
+ * it, and ramps back down to stop exactly at the distance, instead of slamming the motors to
+ * full power and coasting. motionProfileAt() gives the position and velocity the move should
+ * have reached at any time since it started, so a controller can follow it one scheduler tick at
+ * a time, feeding the velocity forward and correcting the position error.
+ *
+ * A trapezoidal profile ramps the velocity linearly, at the given acceleration. An S-curve
+ * profile follows smoothstep ramps, so the acceleration itself builds up and dies away, which is
+ * gentler on the gearboxes and anything sitting on the lift; its ramps take 1.5 times as long for
+ * the same peak acceleration. Moves too short to reach the cruising speed turn around halfway
+ * with a lower peak speed.
+ *
+ * Everything is integer arithmetic. The ramp lengths, cruising time and peak velocity are worked
+ * out once when the profile is planned, and each setpoint after that is a table lookup and a few
+ * multiplies. Units are whatever the caller uses, such as IME ticks or Q16 lift positions.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef MOTIONPROFILE_H_
+#define MOTIONPROFILE_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MOTION_PROFILE_TRAPEZOID = 0,
+    MOTION_PROFILE_S_CURVE,
+} MotionProfileShape;
+
+typedef struct {
+    MotionProfileShape shape;
+    // Distance to move, negative to move backwards
+    long distance;
+    // Peak velocity actually reached, in units per second, never negative
+    long velocity;
+    // Length of each ramp and of the cruise between them, in milliseconds
+    unsigned long rampMs;
+    unsigned long cruiseMs;
+} MotionProfile;
+
+typedef struct {
+    // Distance moved since the start, with the sign of the profile's distance
+    long position;
+    // Velocity in units per second, with the sign of the profile's distance
+    long velocity;
+} MotionSetpoint;
+
+/**
+ * Plans a move.
+ *
+ * @param profile the profile to fill in
+ * @param shape the shape of the ramps
+ * @param distance how far to move, negative to move backwards
+ * @param maxVelocity the fastest to move, in units per second
+ * @param acceleration the hardest to accelerate, in units per second per second
+ */
+void motionProfileInit(MotionProfile *profile, MotionProfileShape shape, long distance,
+    long maxVelocity, long acceleration);
+/**
+ * Returns how long the move takes from start to stop, in milliseconds.
+ */
+unsigned long motionProfileDuration(const MotionProfile *profile);
+/**
+ * Works out where the move should be at a time since it started.
+ *
+ * @param profile the planned move
+ * @param elapsedMs milliseconds since the move started
+ * @param setpoint filled in with the position and velocity at that time
+ * @return true once the move is over, when the setpoint holds at the distance
+ */
+bool motionProfileAt(const MotionProfile *profile, unsigned long elapsedMs,
+    MotionSetpoint *setpoint);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
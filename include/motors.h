@@ -0,0 +1,114 @@
+/** @file motors.h
+ * @brief Header file for the motor configuration table and per-tick motor command frame
+ *
+ * Every motor is described once in motorConfigs, which both operator control and autonomous use.
+ * Subsystems write the speed they want for each motor port into the frame instead of calling
+ * motorSet() directly. Later writes in the same tick replace earlier ones, so a port only ever
+ * gets one command per tick. Flushing the frame hands it to the output stage.
+ *
+ * The output stage is a task of its own that runs every MOTOR_OUTPUT_PERIOD_MS. It ramps each
+ * motor towards its command at no more than the motor's slew per period, then keeps the total
+ * output under a power budget, and finally applies reversal and calls motorSet() for the ports
+ * whose output changed. Only increases in speed are ramped; slowing down is never held back, and
+ * a reversal drops to zero straight away and ramps up from there.
+ *
+ * The budget stands in for the current the Cortex's breakers see, which it can't measure. A motor
+ * draws roughly its output times the battery voltage, so the budget is MOTOR_POWER_BUDGET output
+ * units at MOTOR_NOMINAL_MV and grows as the battery sags. When the outputs add up to more, whole
+ * groups are served in the order of motorGroupPriority, and the first group that doesn't fit is
+ * scaled down evenly, which keeps both sides of the drive and lifts matched. Groups after it stop.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef MOTORS_H_
+#define MOTORS_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Motor ports are numbered 1 to 10
+#define MOTOR_PORTS 10
+// Largest magnitude motorSet() accepts
+#define MOTOR_MAX_SPEED 127
+// Slew value for motors whose output may change by any amount in one output period
+#define MOTOR_NO_SLEW 0
+// How often the output stage writes to the motors, in milliseconds
+#define MOTOR_OUTPUT_PERIOD_MS 10
+// Above the control loop, so outputs keep a steady rhythm, but below the sensors
+#define MOTOR_OUTPUT_PRIORITY (TASK_PRIORITY_DEFAULT + 1)
+// Total output allowed at the nominal battery level, about six motors at full speed
+#define MOTOR_POWER_BUDGET (6 * MOTOR_MAX_SPEED)
+#define MOTOR_NOMINAL_MV 7200
+
+// Groups of motors that work together
+typedef enum {
+    MOTOR_GROUP_NONE = 0,
+    MOTOR_GROUP_DRIVE,
+    MOTOR_GROUP_LOWER_LIFT,
+    MOTOR_GROUP_UPPER_LIFT,
+    MOTOR_GROUP_EXTENDER,
+    MOTOR_GROUP_CLAW,
+    MOTOR_GROUPS
+} MotorGroup;
+
+typedef struct {
+    unsigned char port;
+    // True if the motor is mounted so that positive speeds move the robot backwards
+    bool reversed;
+    // Largest speed magnitude the motor is allowed to run at
+    unsigned char maxSpeed;
+    // Largest increase in output per output period, or MOTOR_NO_SLEW
+    unsigned char slew;
+    MotorGroup group;
+} MotorConfig;
+
+// Configuration of every motor, indexed by port. Unused ports have port 0.
+extern const MotorConfig motorConfigs[MOTOR_PORTS + 1];
+// Every group but MOTOR_GROUP_NONE, most important first, for sharing out the power budget
+extern const MotorGroup motorGroupPriority[MOTOR_GROUPS - 1];
+
+/**
+ * Starts the output stage task. Only the first call does anything. Until it runs, flushed frames
+ * go nowhere.
+ */
+void motorOutputStart();
+/**
+ * Zeroes the frame and forgets what was last written, so the next output writes every port.
+ * Call this whenever the motors may have been changed behind the frame's back, such as at the
+ * start of a competition mode or after calling motorSet() directly.
+ */
+void motorFrameInit();
+/**
+ * Sets the speed a motor should run at when the frame is next flushed.
+ *
+ * @param port the motor port, 1 to 10
+ * @param speed the desired speed, positive being the motor's forward direction for the robot
+ */
+void motorFrameSet(unsigned char port, int speed);
+/**
+ * Sets the speed of every motor in a group, as motorFrameSet() would.
+ */
+void motorFrameSetGroup(MotorGroup group, int speed);
+/**
+ * Returns the speed currently requested for a motor port.
+ */
+int motorFrameGet(unsigned char port);
+/**
+ * Hands the frame to the output stage, which writes it to the motors from its next period on.
+ */
+void motorFrameFlush();
+/**
+ * Returns the output the output stage last wrote to a port, before reversal.
+ */
+int motorOutputGet(unsigned char port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
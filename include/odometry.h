@@ -0,0 +1,88 @@
+/** @file odometry.h
+ * @brief Header file for the odometry task
+ *
+ * A high priority task tracks where the robot is on the field from the drive IMEs and the gyro,
+ * both taken from the same sensor frame. Every pass it turns the change in each side's count
+ * into a distance driven and a change of heading, and moves the pose along the heading halfway
+ * through that change. The gyro only counts whole degrees but doesn't drift when the wheels
+ * slip, and the IMEs are fine grained but do, so the heading follows the IMEs from pass to pass
+ * and is pulled a little towards the gyro every pass. Until the gyro has started, which takes about
+ * a second after a reset, the heading follows the IMEs alone.
+ *
+ * Everything is integer arithmetic, since the Cortex-M3 has no floating point unit: positions
+ * are in IME ticks with ODOMETRY_SHIFT fraction bits, headings in ODOMETRY_TURN units per turn,
+ * and sines come from a quarter wave table. A pass does the same handful of multiplies whatever
+ * the robot is doing, and is timed as the "odometry" profiler section.
+ *
+ * Poses are published like sensor frames, double buffered behind a sequence counter, so
+ * odometryGet() never blocks the task and never returns a pose that is half old and half new.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef ODOMETRY_H_
+#define ODOMETRY_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Update period in milliseconds (200 Hz)
+#define ODOMETRY_PERIOD_MS 5
+#define ODOMETRY_TASK_PRIORITY (TASK_PRIORITY_HIGHEST - 2)
+// Fraction bits of positions
+#define ODOMETRY_SHIFT 8
+// Heading units in one full turn
+#define ODOMETRY_TURN 65536L
+// Distance between the drive wheels in IME ticks, found by turning in place a whole turn and
+// dividing the difference between the sides by 2 pi
+#define ODOMETRY_TRACK_WIDTH 900
+// The heading moves 1 / 2^this of the way to the gyro each pass
+#define ODOMETRY_GYRO_SHIFT 6
+// A larger change of an IME count in one pass is a reset or a bad read, not driving
+#define ODOMETRY_MAX_STEP 200
+
+// Converts a heading to degrees, counterclockwise being positive
+#define odometryDegrees(heading) ((int)((heading) * 360 / ODOMETRY_TURN))
+
+typedef struct {
+    // Number of poses published before this one
+    unsigned long sequence;
+    // millis() of the sensor frame the pose was worked out from
+    unsigned long time;
+    // Position in IME ticks with ODOMETRY_SHIFT fraction bits, x being straight ahead of where
+    // the robot started
+    long x;
+    long y;
+    // Heading in ODOMETRY_TURN units per turn, counterclockwise being positive. It doesn't wrap,
+    // so it counts whole turns like gyroGet() does.
+    long heading;
+} Pose;
+
+/**
+ * Starts the odometry task at the origin, facing along x. Call once from initialize() after
+ * sensorsStart().
+ */
+void odometryStart();
+/**
+ * Copies the most recently published pose.
+ */
+void odometryGet(Pose *pose);
+/**
+ * Moves the pose somewhere else, such as the robot's starting tile. Takes effect at the task's
+ * next pass.
+ *
+ * @param x the position in IME ticks with ODOMETRY_SHIFT fraction bits
+ * @param y the position in IME ticks with ODOMETRY_SHIFT fraction bits
+ * @param heading the heading in ODOMETRY_TURN units per turn
+ */
+void odometrySet(long x, long y, long heading);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
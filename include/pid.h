@@ -0,0 +1,89 @@
+/** @file pid.h
+ * @brief Header file for the integer PID/feedforward controller
+ *
+ * Gains are Q16 fixed point, so a gain of PID_ONE turns an error of 1 into an output of 1. The
+ * controller knows its update period, which keeps the integral and derivative gains in per
+ * second units when a loop runs at a different rate. The integral is clamped so it can never
+ * drive the output past its limit on its own, and it stops growing while the output is saturated
+ * in the direction of the error.
+ *
+ * The per second gains are turned into per update gains once, by pidInit(), so an update is a
+ * handful of 32-bit multiplies with no division. That needs each gain times its error, or times
+ * the change of the measurement for kd, to stay below 2^31: a Q16 gain of PID_ONE * 4 allows
+ * errors up to about 8000, and one of PID_ONE / 100 errors up to a full Q16 lift position.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef PID_H_
+#define PID_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Gain of 1.0 in Q16
+#define PID_ONE 65536
+// Extra fraction bits of the integral, so small integral gains aren't rounded away
+#define PID_INTEGRAL_SHIFT 4
+
+typedef struct {
+    // Proportional gain, Q16
+    int kp;
+    // Integral gain per second, Q16
+    int ki;
+    // Derivative gain in seconds, Q16
+    int kd;
+    // Feedforward gain on the setpoint, Q16
+    int kf;
+    // Output is clamped to -outputLimit..outputLimit. Set with pidSetOutputLimit().
+    int outputLimit;
+    unsigned long periodMs;
+    // Integral gain per update with PID_INTEGRAL_SHIFT more fraction bits, and derivative gain
+    // per update, both worked out from the per second gains by pidInit()
+    int kiPerUpdate;
+    int kdPerUpdate;
+    // Integral term of the output, in the same units as kiPerUpdate times the error, and the
+    // most it may reach
+    int integral;
+    int maxIntegral;
+    int lastMeasured;
+    bool hasLast;
+} Pid;
+
+/**
+ * Sets up a controller with no feedforward and an output limit of MOTOR_MAX_SPEED.
+ *
+ * @param pid the controller to set up
+ * @param kp the proportional gain, Q16
+ * @param ki the integral gain per second, Q16
+ * @param kd the derivative gain in seconds, Q16
+ * @param periodMs the time between calls to pidUpdate() in milliseconds
+ */
+void pidInit(Pid *pid, int kp, int ki, int kd, unsigned long periodMs);
+/**
+ * Changes the output limit, from MOTOR_MAX_SPEED, which also bounds the integral term.
+ */
+void pidSetOutputLimit(Pid *pid, int limit);
+/**
+ * Clears the integral and derivative history, for when the controller starts a new move.
+ */
+void pidReset(Pid *pid);
+/**
+ * Runs one controller update.
+ *
+ * @param pid the controller
+ * @param setpoint the target value
+ * @param measured the current value
+ * @return the clamped output
+ */
+int pidUpdate(Pid *pid, int setpoint, int measured);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
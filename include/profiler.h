@@ -0,0 +1,103 @@
+/** @file profiler.h
+ * @brief Header file for the control loop profiler
+ *
+ * The scheduler times every callback it runs, and the whole tick, as a profiler section named
+ * after the callback. Times come from the Cortex-M3's DWT cycle counter, so they are exact to a
+ * cycle. Each section keeps its all-time minimum, average and maximum, and a ring of the last
+ * PROFILE_SAMPLES durations that the 99th percentile is taken from when a report is asked for.
+ *
+ * Profiling starts disabled. Until profilerEnable() is called, the scheduler only pays for one
+ * flag check per callback.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Most sections that can be profiled, one per distinct callback name plus the whole tick. The
+// tree has 18: the tick, odometry, 5 runtime callbacks, 8 driver control ones and 3 more in
+// autonomous.
+#define PROFILE_MAX_SECTIONS 20
+// Durations kept per section for the 99th percentile
+#define PROFILE_SAMPLES 128
+// Core clock of the Cortex's STM32F103, in cycles per microsecond
+#define PROFILE_CYCLES_PER_US 72
+// Section returned when the table is full, which is never timed
+#define PROFILE_NONE (-1)
+// Ticks between LCD redraws
+#define PROFILE_LCD_TICKS 25
+
+// Summary of one section, durations in cycles
+typedef struct {
+    const char *name;
+    unsigned long count;
+    unsigned long min;
+    unsigned long average;
+    unsigned long max;
+    unsigned long p99;
+} ProfileStats;
+
+/**
+ * Starts or stops timing. Starting also turns on the cycle counter.
+ */
+void profilerEnable(bool enable);
+bool profilerIsEnabled();
+/**
+ * Returns the section with this name, adding it if it is new.
+ *
+ * @return the section number, or PROFILE_NONE if the table is full
+ */
+int profilerSection(const char *name);
+/**
+ * Returns the name of the first section that didn't fit in the table, which is never timed, or
+ * NULL if every section fit. profilerPrint() reports it too.
+ */
+const char *profilerOverflow();
+/**
+ * Returns the current cycle count. The simulation counts host time, at the Cortex's clock rate.
+ */
+unsigned long profilerClock();
+/**
+ * Adds one duration, as a difference of profilerClock() values, to a section.
+ */
+void profilerRecord(int section, unsigned long cycles);
+/**
+ * Clears the durations of every section, keeping the sections.
+ */
+void profilerReset();
+/**
+ * Returns the number of sections.
+ */
+int profilerSections();
+/**
+ * Summarizes a section into stats.
+ *
+ * @return false if there is no such section
+ */
+bool profilerGetStats(int section, ProfileStats *stats);
+/**
+ * Prints a table of every section to stdout, in microseconds.
+ */
+void profilerPrint();
+/**
+ * Shows one section on an LCD. The left and right LCD buttons step through the sections, and
+ * the center button clears them. Call this every tick; it only redraws when a button is pressed
+ * or every PROFILE_LCD_TICKS ticks, since each redraw is a slow serial write.
+ *
+ * @param lcdPort the LCD, either uart1 or uart2, already initialized with lcdInit()
+ */
+void profilerShowLcd(PROS_FILE *lcdPort);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,73 @@
+/** @file runtime.h
+ * @brief Header file for the persistent control runtime
+ *
+ * PROS starts a new task for operatorControl() or autonomous() every time the robot is enabled,
+ * and kills it when the mode ends. Instead of building the control loop up again in each of
+ * those tasks, one control task started from initialize() runs the scheduler for as long as the
+ * robot is on, next to the sensor, odometry and motor output tasks. The competition mode tasks
+ * only pick which behavior it runs.
+ *
+ * A behavior is a set of scheduler callbacks. Every tick runs eventsDispatch() and setPotents()
+ * first, then the active behavior's callbacks, then motorFrameFlush() and blackboxRecord(). A
+ * switch to another behavior takes effect at the next tick boundary: the scheduler returns, the
+ * runtime stops any running motion primitives and registers the new behavior, and the first
+ * tick of the new behavior runs straight away. The motor frame, lift, sensors and their filters
+ * carry on across the switch, so nothing starts cold.
+ *
+ * The robot runs idleBehavior, which holds every motor at zero, until a mode picks something
+ * else, and goes back to it whenever the robot is disabled.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef RUNTIME_H_
+#define RUNTIME_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RUNTIME_TASK_PRIORITY TASK_PRIORITY_DEFAULT
+// How often a competition mode's task wakes up while it has nothing to do, in milliseconds
+#define RUNTIME_MODE_WAIT_MS 1000
+
+typedef struct {
+    const char *name;
+    // Sets the behavior up and registers its callbacks with schedulerRegister(). Runs in the
+    // control task between two ticks.
+    void (*start)();
+} Behavior;
+
+extern const Behavior idleBehavior;
+
+/**
+ * Starts the control task running idleBehavior. Call once from initialize() after the sensor and
+ * motor output tasks have started.
+ */
+void runtimeStart();
+/**
+ * Switches to a behavior at the next tick boundary. Can be called from any task.
+ */
+void runtimeSetBehavior(const Behavior *behavior);
+/**
+ * Switches back to the behavior that was running before the active one, for a behavior that has
+ * finished.
+ */
+void runtimeFinish();
+/**
+ * Returns the behavior that is running.
+ */
+const Behavior *runtimeBehavior();
+/**
+ * Keeps a competition mode's task alive, doing nothing, until the kernel stops it.
+ */
+void runtimeWait();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+/** @file scheduler.h
+ * @brief Header file for the fixed-rate control loop scheduler
+ *
+ * The scheduler runs registered subsystem callbacks once per tick. Ticks are paced with
+ * taskDelayUntil(), so the period stays fixed no matter how long the callbacks take. The start
+ * jitter and run time of every tick are measured with micros(). When a tick overruns its period,
+ * the next tick runs in degraded mode and skips every callback registered as SCHED_LOW.
+ *
+ * While the profiler is enabled, every callback is also timed as a profiler section named after
+ * it, and the whole tick as the "tick" section.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Control loop period in milliseconds
+#define SCHED_PERIOD_MS 20
+// Most callbacks that can be registered at once
+#define SCHED_MAX_CALLBACKS 16
+
+// Callback priorities. Low priority callbacks are skipped on the tick after an overrun.
+#define SCHED_HIGH 0
+#define SCHED_LOW 1
+
+typedef void (*SchedCallback)();
+
+// Timing statistics, all durations in microseconds
+typedef struct {
+    unsigned long ticks;
+    unsigned long overruns;
+    // Ticks that ran in degraded mode
+    unsigned long degradedTicks;
+    // Ticks skipped because the loop started a whole period or more late
+    unsigned long missedTicks;
+    // Actual tick start minus scheduled tick start, including the lateness of skipped ticks
+    long lastJitter;
+    long maxJitter;
+    // Time spent running the callbacks of a tick
+    unsigned long lastDuration;
+    unsigned long maxDuration;
+} SchedStats;
+
+/**
+ * Clears all registered callbacks and statistics and sets the tick period.
+ *
+ * @param periodMs the tick period in milliseconds
+ */
+void schedulerInit(unsigned long periodMs);
+/**
+ * Registers a callback to run every tick, in registration order. Use schedulerRegister(), which
+ * names the callback after its function.
+ *
+ * @param callback the function to run
+ * @param name the profiler section to time it as
+ * @param priority SCHED_HIGH or SCHED_LOW
+ * @return true if registered, false if the table is full
+ */
+bool schedulerRegisterNamed(SchedCallback callback, const char *name, unsigned char priority);
+#define schedulerRegister(callback, priority) \
+    schedulerRegisterNamed(callback, #callback, priority)
+/**
+ * Runs the registered callbacks at the fixed period until schedulerStop() is called.
+ */
+void schedulerRun();
+/**
+ * Makes schedulerRun() return once the current tick's callbacks have finished.
+ */
+void schedulerStop();
+/**
+ * Copies the current timing statistics into stats.
+ */
+void schedulerGetStats(SchedStats *stats);
+/**
+ * Returns true if the current tick is skipping low priority callbacks.
+ */
+bool schedulerIsDegraded();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
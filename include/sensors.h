@@ -0,0 +1,164 @@
+/** @file sensors.h
+ * @brief Header file for the background sensor acquisition task
+ *
+ * A high priority task samples every analog and digital input at a fixed rate and publishes
+ * each sample set as one SensorFrame. Frames are double buffered behind a sequence counter:
+ * the task fills the buffer readers are not using and then bumps the counter, and readers copy
+ * the published buffer and retry if the counter moved while they were copying. Readers never
+ * block the task and never take a mutex, and a frame is never half old and half new.
+ *
+ * Analog channels are read in analogReadCalibratedHR() units, 4 bits more than analogRead(), less
+ * the channel's calibration offset, and each channel is run through the filter given for it in
+ * sensorFilters: a moving average or median of the last few samples, or a one-pole IIR filter.
+ * Filtering at the sampling rate smooths out noise well within one control tick, instead of the
+ * control code seeing a single noisy sample. Each frame also carries the rate of change of every
+ * filtered channel, taken over the last SENSOR_RATE_SAMPLES samples.
+ *
+ * Calibration offsets are kept here rather than by analogCalibrate(), which samples for half a
+ * second every boot and has no way to be given a stored offset. The channels marked in
+ * sensorCalibrated are measured once, with the robot still, and the offsets are saved to
+ * SENSOR_CALIBRATION_FILE. Later boots, including a reset in the middle of a match, load the
+ * file and are reading sensors within milliseconds. A background task then checks the cache the
+ * first time the robot is disabled and still. If the offsets seem to have moved by more than
+ * SENSOR_CALIBRATION_TOLERANCE it only flags them as SENSOR_CALIBRATION_MISMATCH, since the lift
+ * may simply not be at the bottom, and keeps using them. sensorsRequestCalibration() asks that
+ * task to measure and save new offsets, and sensorsCalibrate() does it on the spot.
+ *
+ * gyroInit() can't be given a stored zero either and samples for about a second, so the same
+ * background task starts the gyro instead of initialize(). Frames say whether the gyro has
+ * started yet in gyroValid, and read 0 degrees until it has.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef SENSORS_H_
+#define SENSORS_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sampling period in milliseconds (1 kHz)
+#define SENSOR_PERIOD_MS 1
+#define SENSOR_TASK_PRIORITY (TASK_PRIORITY_HIGHEST - 1)
+// Digital pins sampled, 1 to 12
+#define SENSOR_DIGITAL_PINS 12
+// IMEs sampled, addresses 0 up to this
+#define SENSOR_IMES 2
+// Longest moving average or median window, in samples
+#define SENSOR_FILTER_MAX 16
+// Samples the rate of change is measured across
+#define SENSOR_RATE_SAMPLES 10
+
+#define SENSOR_CALIBRATION_FILE "calib"
+#define SENSOR_CALIBRATION_VERSION 1
+#define SENSOR_CALIBRATION_BYTES (4 + 4 * BOARD_NR_ADC_PINS + 2)
+// Samples averaged into an offset, one per millisecond, as many as analogCalibrate() takes
+#define SENSOR_CALIBRATION_SAMPLES 512
+// How far a cached offset may be from a new measurement, in analogReadCalibratedHR() units
+#define SENSOR_CALIBRATION_TOLERANCE (8 * 16)
+// Largest spread of raw samples while measuring that still counts as the robot being still
+#define SENSOR_CALIBRATION_STILL 12
+// How often the background task looks for a chance to check the offsets, in milliseconds
+#define SENSOR_CALIBRATION_CHECK_MS 1000
+#define SENSOR_CALIBRATION_TASK_PRIORITY (TASK_PRIORITY_DEFAULT - 1)
+
+typedef enum {
+    // The latest sample as is
+    SENSOR_FILTER_NONE = 0,
+    // Mean of the last length samples, which smooths noise best
+    SENSOR_FILTER_AVERAGE,
+    // Median of the last length samples, which ignores spikes
+    SENSOR_FILTER_MEDIAN,
+    // Moves 1 / 2^length of the way to each sample, cheap smoothing with a long memory
+    SENSOR_FILTER_IIR,
+} SensorFilterType;
+
+typedef struct {
+    SensorFilterType type;
+    // Window in samples, up to SENSOR_FILTER_MAX, or the shift of the IIR filter
+    unsigned char length;
+} SensorFilter;
+
+// Filter of each analog channel, indexed by channel (1 to 8)
+extern const SensorFilter sensorFilters[BOARD_NR_ADC_PINS + 1];
+// Whether each analog channel reads relative to a calibration offset, indexed by channel
+extern const bool sensorCalibrated[BOARD_NR_ADC_PINS + 1];
+
+// Where the calibration offsets in use came from
+typedef enum {
+    // Loaded from SENSOR_CALIBRATION_FILE and not checked yet
+    SENSOR_CALIBRATION_CACHED = 0,
+    // Loaded from SENSOR_CALIBRATION_FILE and confirmed by a measurement
+    SENSOR_CALIBRATION_CHECKED,
+    // Measured since boot
+    SENSOR_CALIBRATION_MEASURED,
+    // Loaded from SENSOR_CALIBRATION_FILE and still in use, but a measurement disagreed
+    SENSOR_CALIBRATION_MISMATCH,
+} SensorCalibration;
+
+typedef struct {
+    // Number of frames published before this one
+    unsigned long sequence;
+    // micros() when sampling started
+    unsigned long time;
+    // Latest sample of each analog channel less its calibration offset, in analogRead() units,
+    // indexed by channel (1 to 8)
+    int analog[BOARD_NR_ADC_PINS + 1];
+    // Each analog channel filtered, in analogReadCalibratedHR() units, 16 to a count
+    int filtered[BOARD_NR_ADC_PINS + 1];
+    // Rate of change of each filtered channel in analogReadCalibratedHR() units per second
+    int rate[BOARD_NR_ADC_PINS + 1];
+    // digitalRead() of each digital pin, bit n set when pin n is HIGH
+    unsigned int digital;
+    // imeGet() count of each IME, indexed by address
+    int ime[SENSOR_IMES];
+    // Bit n set when IME n was read successfully
+    unsigned int imeValid;
+    // gyroGet() in degrees, cumulative, or 0 if the gyro hasn't started
+    int gyro;
+    // False until the background task has started the gyro, about a second after sensorsStart()
+    bool gyroValid;
+} SensorFrame;
+
+// True if the digital pin was HIGH in the frame
+#define sensorDigital(frame, pin) ((((frame)->digital) >> (pin)) & 1)
+
+/**
+ * Initializes the IMEs, loads the calibration offsets, samples one frame immediately and starts
+ * the acquisition task and the task that starts the gyro and checks the offsets. Without a valid
+ * SENSOR_CALIBRATION_FILE this first measures the offsets, which takes about half a second with
+ * the robot still. Call once from initialize().
+ *
+ * @param periodMs the sampling period in milliseconds
+ */
+void sensorsStart(unsigned long periodMs);
+/**
+ * Measures the calibration offsets now and saves them, taking about half a second. Call only
+ * with the robot still and disabled.
+ *
+ * @return true if the offsets were saved to SENSOR_CALIBRATION_FILE
+ */
+bool sensorsCalibrate();
+/**
+ * Has the background task measure and save the offsets the next time the robot is disabled and
+ * still, whatever the cached ones are. Only ask with the lift resting at the bottom.
+ */
+void sensorsRequestCalibration();
+/**
+ * Returns where the calibration offsets in use came from.
+ */
+SensorCalibration sensorsCalibrationStatus();
+/**
+ * Copies the most recently published frame.
+ */
+void sensorsGet(SensorFrame *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+/** @file telemetry.h
+ * @brief Header file for the binary telemetry channel
+ *
+ * Control code logs fixed-size records with telemetryLog(), which copies them into a single
+ * producer, single consumer ring and returns without waiting on anything. A low priority task
+ * drains the ring to a serial stream whenever the control loop is idle, so logging costs the
+ * control task a few dozen cycles instead of a formatted, blocking printf(). If the stream falls
+ * behind and the ring fills, new records are dropped and counted rather than blocking, and a
+ * TELEMETRY_DROPPED record reports how many once the stream catches up.
+ *
+ * All records logged from one task share one ring, so only one task may call telemetryLog().
+ *
+ * On the wire each record is TELEMETRY_RECORD_BYTES little-endian bytes: the type, three zero
+ * bytes, the time in milliseconds and TELEMETRY_VALUES values, all 32 bits. Each is framed with
+ * Consistent Overhead Byte Stuffing and ends with a zero byte, so a reader can join the stream
+ * at any point, and anything printf() writes in between is skipped. tools/telemetry decodes a
+ * capture into CSV.
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Values per record
+#define TELEMETRY_VALUES 3
+#define TELEMETRY_RECORD_BYTES (8 + 4 * TELEMETRY_VALUES)
+// Records the ring holds, a power of two
+#define TELEMETRY_RING_RECORDS 32
+// How often the drain task empties the ring, in milliseconds
+#define TELEMETRY_PERIOD_MS 10
+// Below the control loop, which runs at the default priority
+#define TELEMETRY_TASK_PRIORITY (TASK_PRIORITY_DEFAULT - 1)
+
+// Record types
+// Values: records dropped since the last one of these
+#define TELEMETRY_DROPPED 0
+// Values: left and right upper lift potentiometers in Q16, left minus right in Q16
+#define TELEMETRY_POTENTS 1
+
+typedef struct {
+    unsigned char type;
+    unsigned long time;
+    long values[TELEMETRY_VALUES];
+} TelemetryRecord;
+
+/**
+ * Starts the task that drains the ring into a stream. Only the first call does anything.
+ *
+ * @param stream stdout, or a UART after usartInit()
+ */
+void telemetryStart(PROS_FILE *stream);
+/**
+ * Queues a record, stamped with the current time, without blocking. Unused values are zero.
+ *
+ * @return false if the ring was full and the record was dropped
+ */
+bool telemetryLog(unsigned char type, long a, long b, long c);
+/**
+ * Returns the number of records dropped because the ring was full, ever.
+ */
+unsigned long telemetryDropped();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
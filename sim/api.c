@@ -0,0 +1,987 @@
+/** @file api.c
+ * @brief Host implementation of the PROS API.h functions for the simulation
+ *
+ * Tasks are coroutines run one at a time by a discrete-event scheduler on a virtual clock, and
+ * motors and sensors are backed by the physics model. The scheduler follows FreeRTOS rules: the
+ * highest priority ready task runs, and a task only gives up the processor when it blocks or a
+ * higher priority task becomes ready. Ties always break the same way, so a run with the same
+ * inputs always interleaves the same way and produces the same result.
+ *
+ * Files opened with fopen() live in the directory given to simSetFileSystem(). stdout goes to
+ * the host's standard output, and the UARTs are discarded. Telemetry started on stdout goes to the
+ * file given to simSetTelemetry() instead, or nowhere, so its binary frames don't end up mixed
+ * with the report.
+ */
+
+#include <fcntl.h>
+#include <setjmp.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "sim.h"
+
+// Not declared anywhere else, since the simulation never includes <stdio.h>
+int vsnprintf(char *buffer, size_t limit, const char *format, va_list args);
+
+// -------------------- Scheduler --------------------
+
+// Host stack for each simulated task, far more than the Cortex would give it
+#define SIM_STACK_BYTES (256 * 1024)
+// Wake time of a task blocked with no timeout
+#define NEVER (~0ULL)
+
+typedef struct {
+    // Where the task resumes, once it has started
+    jmp_buf resume;
+    // Where the task starts, until it has
+    ucontext_t start;
+    bool started;
+    char *stack;
+    TaskCode code;
+    void *parameters;
+    unsigned int priority;
+    unsigned int state;
+    // Virtual time a sleeping or blocked task wakes up at, or NEVER
+    unsigned long long wakeTime;
+    // Mutex or semaphore the task is blocked on, NULL if just sleeping
+    void *waitingOn;
+    bool timedOut;
+    // Order tasks became ready or blocked in, to break ties deterministically
+    unsigned long long sequence;
+} SimTask;
+
+// Task 0 is the host's main thread, which runs initializeIO() and initialize()
+static SimTask tasks[TASK_MAX];
+static SimTask *current = &tasks[0];
+static unsigned long long sequence = 0;
+// Virtual time in microseconds
+static unsigned long long now = 0;
+static unsigned long long nextPhysics = 0;
+
+unsigned long micros() {
+    return (unsigned long)now;
+}
+
+unsigned long millis() {
+    return (unsigned long)(now / 1000);
+}
+
+// The profiler's cycle counter, from the host's clock
+unsigned long simCycles() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    unsigned long long nanos = time.tv_sec * 1000000000ULL + time.tv_nsec;
+    return (unsigned long)(nanos * PROFILE_CYCLES_PER_US / 1000);
+}
+
+// Moves virtual time forward, stepping the physics at every period boundary on the way
+static void advanceTo(unsigned long long time) {
+    while (nextPhysics <= time) {
+        now = nextPhysics;
+        physicsStep();
+        nextPhysics += SIM_PHYSICS_PERIOD_US;
+    }
+    now = time;
+}
+
+static void makeReady(SimTask *task) {
+    task->state = TASK_RUNNABLE;
+    task->waitingOn = NULL;
+    task->sequence = sequence++;
+}
+
+// Highest priority runnable task, oldest first among equals, or NULL if none
+static SimTask *pickReady() {
+    SimTask *best = NULL;
+    for (int i = 0; i < TASK_MAX; i++) {
+        SimTask *task = &tasks[i];
+        if (task->state != TASK_RUNNABLE && task->state != TASK_RUNNING)
+            continue;
+        if (best == NULL || task->priority > best->priority ||
+                (task->priority == best->priority && task->sequence < best->sequence))
+            best = task;
+    }
+    return best;
+}
+
+/*
+ * Switches to the task that should run now. The current task must already have set its own
+ * state; if it is still runnable it competes like any other. When nothing can run, virtual time
+ * jumps straight to the next wake up, which is what makes the simulation faster than real time.
+ */
+static void reschedule() {
+    SimTask *next = pickReady();
+    while (next == NULL) {
+        unsigned long long earliest = NEVER;
+        for (int i = 0; i < TASK_MAX; i++) {
+            if (tasks[i].state == TASK_SLEEPING && tasks[i].wakeTime < earliest)
+                earliest = tasks[i].wakeTime;
+        }
+        if (earliest == NEVER) {
+            printf("deadlock: every task is blocked forever at %lu ms\n", millis());
+            _exit(3);
+        }
+        advanceTo(earliest);
+        // Wake in the order they went to sleep, so ties always resolve the same way
+        for (int i = 0; i < TASK_MAX; i++) {
+            SimTask *task = &tasks[i];
+            if (task->state == TASK_SLEEPING && task->wakeTime <= now) {
+                task->timedOut = task->waitingOn != NULL;
+                task->waitingOn = NULL;
+                task->state = TASK_RUNNABLE;
+            }
+        }
+        next = pickReady();
+    }
+
+    SimTask *previous = current;
+    current = next;
+    next->state = TASK_RUNNING;
+    if (next == previous)
+        return;
+    // _setjmp() and _longjmp() leave the signal mask alone, so unlike swapcontext() they switch
+    // tasks without a system call. ucontext is only needed to start a task on its own stack.
+    if (_setjmp(previous->resume) == 0) {
+        if (next->started) {
+            _longjmp(next->resume, 1);
+        } else {
+            next->started = true;
+            setcontext(&next->start);
+        }
+    }
+}
+
+// Lets a higher priority task that just became ready run right away, as FreeRTOS would
+static void preempt() {
+    SimTask *next = pickReady();
+    if (next != NULL && next != current && next->priority > current->priority) {
+        current->state = TASK_RUNNABLE;
+        reschedule();
+    }
+}
+
+// Blocks the current task until the wake time, or until it is handed the object it waits on
+static void block(void *object, unsigned long long wakeTime) {
+    current->state = TASK_SLEEPING;
+    current->waitingOn = object;
+    current->wakeTime = wakeTime;
+    current->timedOut = false;
+    current->sequence = sequence++;
+    reschedule();
+    // Suspended while asleep, so wait to be resumed
+    while (current->state == TASK_SUSPENDED)
+        reschedule();
+}
+
+static void sleepUntil(unsigned long long time) {
+    if (time <= now) {
+        // Still gives equal priority tasks a turn, like a zero delay
+        current->state = TASK_RUNNABLE;
+        current->sequence = sequence++;
+        reschedule();
+        return;
+    }
+    block(NULL, time);
+}
+
+// -------------------- Tasks --------------------
+
+static void taskEntry(int index) {
+    SimTask *task = &tasks[index];
+    task->code(task->parameters);
+    task->state = TASK_DEAD;
+    reschedule();
+}
+
+TaskHandle taskCreate(TaskCode taskCode, const unsigned int stackDepth, void *parameters,
+        const unsigned int priority) {
+    int index = 1;
+    while (index < TASK_MAX && tasks[index].state != TASK_DEAD)
+        index++;
+    if (index == TASK_MAX)
+        return NULL;
+
+    SimTask *task = &tasks[index];
+    // A dead task's stack can only be reused once we are off it, which we are here
+    if (task->stack == NULL)
+        task->stack = malloc(SIM_STACK_BYTES);
+    getcontext(&task->start);
+    task->start.uc_stack.ss_sp = task->stack;
+    task->start.uc_stack.ss_size = SIM_STACK_BYTES;
+    task->start.uc_link = NULL;
+    makecontext(&task->start, (void (*)())taskEntry, 1, index);
+    task->started = false;
+
+    task->code = taskCode;
+    task->parameters = parameters;
+    task->priority = priority;
+    makeReady(task);
+    preempt();
+    return task;
+}
+
+void taskDelete(TaskHandle taskToDelete) {
+    SimTask *task = taskToDelete != NULL ? taskToDelete : current;
+    task->state = TASK_DEAD;
+    if (task == current)
+        reschedule();
+}
+
+void taskDelay(const unsigned long msToDelay) {
+    sleepUntil(now + msToDelay * 1000ULL);
+}
+
+void taskDelayUntil(unsigned long *previousWakeTime, const unsigned long cycleTime) {
+    *previousWakeTime += cycleTime;
+    sleepUntil(*previousWakeTime * 1000ULL);
+}
+
+unsigned int taskGetCount() {
+    unsigned int count = 0;
+    for (int i = 0; i < TASK_MAX; i++) {
+        if (tasks[i].state != TASK_DEAD)
+            count++;
+    }
+    return count;
+}
+
+unsigned int taskGetState(TaskHandle task) {
+    return task != NULL ? ((SimTask *)task)->state : TASK_DEAD;
+}
+
+unsigned int taskPriorityGet(const TaskHandle task) {
+    return task != NULL ? ((SimTask *)task)->priority : current->priority;
+}
+
+void taskPrioritySet(TaskHandle task, const unsigned int newPriority) {
+    SimTask *simTask = task != NULL ? task : current;
+    simTask->priority = newPriority;
+    preempt();
+}
+
+void taskSuspend(TaskHandle taskToSuspend) {
+    SimTask *task = taskToSuspend != NULL ? taskToSuspend : current;
+    if (task->state == TASK_DEAD)
+        return;
+    task->state = TASK_SUSPENDED;
+    if (task == current) {
+        while (current->state == TASK_SUSPENDED)
+            reschedule();
+    }
+}
+
+void taskResume(TaskHandle taskToResume) {
+    SimTask *task = taskToResume;
+    if (task != NULL && task->state == TASK_SUSPENDED) {
+        makeReady(task);
+        preempt();
+    }
+}
+
+typedef struct {
+    void (*fn)(void);
+    unsigned long increment;
+} RunLoop;
+
+static void runLoop(void *argument) {
+    RunLoop loop = *(RunLoop *)argument;
+    free(argument);
+    unsigned long wakeTime = millis();
+    while (1) {
+        loop.fn();
+        taskDelayUntil(&wakeTime, loop.increment);
+    }
+}
+
+TaskHandle taskRunLoop(void (*fn)(void), const unsigned long increment) {
+    RunLoop *loop = malloc(sizeof(RunLoop));
+    loop->fn = fn;
+    loop->increment = increment;
+    return taskCreate(runLoop, TASK_DEFAULT_STACK_SIZE, loop, TASK_PRIORITY_DEFAULT + 1);
+}
+
+void delay(const unsigned long time) {
+    taskDelay(time);
+}
+
+void wait(const unsigned long time) {
+    taskDelay(time);
+}
+
+void waitUntil(unsigned long *previousWakeTime, const unsigned long time) {
+    taskDelayUntil(previousWakeTime, time);
+}
+
+void delayMicroseconds(const unsigned long us) {
+    sleepUntil(now + us);
+}
+
+// -------------------- Mutexes and semaphores --------------------
+
+typedef struct {
+    SimTask *owner;
+} SimMutex;
+
+typedef struct {
+    bool given;
+} SimSemaphore;
+
+static unsigned long long blockDeadline(unsigned long blockTime) {
+    return blockTime == (unsigned long)-1 ? NEVER : now + blockTime * 1000ULL;
+}
+
+// Highest priority task blocked on an object, longest waiting first among equals
+static SimTask *firstWaiter(void *object) {
+    SimTask *best = NULL;
+    for (int i = 0; i < TASK_MAX; i++) {
+        SimTask *task = &tasks[i];
+        if (task->state != TASK_SLEEPING || task->waitingOn != object)
+            continue;
+        if (best == NULL || task->priority > best->priority ||
+                (task->priority == best->priority && task->sequence < best->sequence))
+            best = task;
+    }
+    return best;
+}
+
+Mutex mutexCreate() {
+    SimMutex *mutex = malloc(sizeof(SimMutex));
+    mutex->owner = NULL;
+    return mutex;
+}
+
+bool mutexTake(Mutex mutex, const unsigned long blockTime) {
+    SimMutex *simMutex = mutex;
+    if (simMutex->owner == NULL) {
+        simMutex->owner = current;
+        return true;
+    }
+    if (blockTime == 0)
+        return false;
+    // mutexGive() hands the mutex straight to the task it wakes
+    block(simMutex, blockDeadline(blockTime));
+    return !current->timedOut;
+}
+
+bool mutexGive(Mutex mutex) {
+    SimMutex *simMutex = mutex;
+    if (simMutex->owner != current)
+        return false;
+    SimTask *waiter = firstWaiter(simMutex);
+    simMutex->owner = waiter;
+    if (waiter != NULL) {
+        makeReady(waiter);
+        preempt();
+    }
+    return true;
+}
+
+void mutexDelete(Mutex mutex) {
+    free(mutex);
+}
+
+Semaphore semaphoreCreate() {
+    SimSemaphore *semaphore = malloc(sizeof(SimSemaphore));
+    // Binary semaphores start out given, as in FreeRTOS
+    semaphore->given = true;
+    return semaphore;
+}
+
+bool semaphoreGive(Semaphore semaphore) {
+    SimSemaphore *simSemaphore = semaphore;
+    if (simSemaphore->given)
+        return false;
+    SimTask *waiter = firstWaiter(simSemaphore);
+    if (waiter != NULL) {
+        // The waiter takes it straight away
+        makeReady(waiter);
+        preempt();
+    } else {
+        simSemaphore->given = true;
+    }
+    return true;
+}
+
+bool semaphoreTake(Semaphore semaphore, const unsigned long blockTime) {
+    SimSemaphore *simSemaphore = semaphore;
+    if (simSemaphore->given) {
+        simSemaphore->given = false;
+        return true;
+    }
+    if (blockTime == 0)
+        return false;
+    block(simSemaphore, blockDeadline(blockTime));
+    return !current->timedOut;
+}
+
+void semaphoreDelete(Semaphore semaphore) {
+    free(semaphore);
+}
+
+// -------------------- Competition and joystick --------------------
+
+bool isAutonomous() {
+    return simRobot.competition.autonomous;
+}
+
+bool isEnabled() {
+    return simRobot.competition.enabled;
+}
+
+bool isOnline() {
+    return simRobot.competition.online;
+}
+
+bool isJoystickConnected(unsigned char joystick) {
+    return joystick == 1 || joystick == 2;
+}
+
+int joystickGetAnalog(unsigned char joystick, unsigned char axis) {
+    if (joystick < 1 || joystick > 2 || axis < 1 || axis > 4)
+        return 0;
+    int value = simRobot.joystick.analog[joystick - 1][axis - 1];
+    return value;
+}
+
+bool joystickGetDigital(unsigned char joystick, unsigned char buttonGroup,
+        unsigned char button) {
+    if (joystick < 1 || joystick > 2 || buttonGroup < 5 || buttonGroup > 8)
+        return false;
+    bool pressed = (simRobot.joystick.digital[joystick - 1][buttonGroup - 5] & button) != 0;
+    return pressed;
+}
+
+unsigned int powerLevelMain() {
+    return simRobot.battery;
+}
+
+unsigned int powerLevelBackup() {
+    return 9000;
+}
+
+void setTeamName(const char *name) {
+}
+
+// -------------------- Analog and digital I/O --------------------
+
+static int calibration[BOARD_NR_ADC_PINS + 1];
+
+int analogRead(unsigned char channel) {
+    if (channel < 1 || channel > BOARD_NR_ADC_PINS)
+        return 0;
+    int value = physicsAnalog(channel);
+    return value;
+}
+
+int analogCalibrate(unsigned char channel) {
+    if (channel < 1 || channel > BOARD_NR_ADC_PINS)
+        return 0;
+    // Averages samples like the real thing, but without taking half a second
+    int total = 0;
+    for (int i = 0; i < 16; i++)
+        total += analogRead(channel);
+    calibration[channel] = total / 16;
+    return calibration[channel];
+}
+
+int analogReadCalibrated(unsigned char channel) {
+    if (channel < 1 || channel > BOARD_NR_ADC_PINS)
+        return 0;
+    return analogRead(channel) - calibration[channel];
+}
+
+int analogReadCalibratedHR(unsigned char channel) {
+    if (channel < 1 || channel > BOARD_NR_ADC_PINS)
+        return 0;
+    return (analogRead(channel) - calibration[channel]) * 16;
+}
+
+bool digitalRead(unsigned char pin) {
+    if (pin < 1 || pin > BOARD_NR_GPIO_PINS)
+        return false;
+    bool value = simRobot.digital[pin];
+    return value;
+}
+
+void digitalWrite(unsigned char pin, bool value) {
+    if (pin < 1 || pin > BOARD_NR_GPIO_PINS)
+        return;
+    simRobot.digital[pin] = value;
+}
+
+void pinMode(unsigned char pin, unsigned char mode) {
+}
+
+// Pin change interrupt handlers and the edges they fire on, by pin
+static InterruptHandler interruptHandlers[BOARD_NR_GPIO_PINS + 1];
+static unsigned char interruptEdges[BOARD_NR_GPIO_PINS + 1];
+
+void ioSetInterrupt(unsigned char pin, unsigned char edges, InterruptHandler handler) {
+    if (pin < 1 || pin > BOARD_NR_GPIO_PINS)
+        return;
+    interruptHandlers[pin] = handler;
+    interruptEdges[pin] = edges;
+}
+
+void ioClearInterrupt(unsigned char pin) {
+    if (pin >= 1 && pin <= BOARD_NR_GPIO_PINS)
+        interruptHandlers[pin] = NULL;
+}
+
+void simSetDigital(unsigned char pin, bool value) {
+    if (pin < 1 || pin > BOARD_NR_GPIO_PINS || simRobot.digital[pin] == value)
+        return;
+    simRobot.digital[pin] = value;
+    // Runs the handler straight away, as the interrupt would interrupt whatever task is running
+    unsigned char edge = value ? INTERRUPT_EDGE_RISING : INTERRUPT_EDGE_FALLING;
+    if (interruptHandlers[pin] != NULL && (interruptEdges[pin] & edge))
+        interruptHandlers[pin](pin);
+}
+
+// -------------------- Motors --------------------
+
+int motorGet(unsigned char channel) {
+    if (channel < 1 || channel > MOTOR_PORTS)
+        return 0;
+    int speed = simRobot.motors[channel];
+    return speed;
+}
+
+// Every motorSet() call as "ms,port,speed" lines, while tracing
+static bool tracing = false;
+static char *trace = NULL;
+static size_t traceLength = 0;
+static size_t traceCapacity = 0;
+
+void simTraceMotors() {
+    tracing = true;
+    traceLength = 0;
+}
+
+const char *simMotorTrace(size_t *length) {
+    *length = traceLength;
+    return trace;
+}
+
+static void traceMotor(unsigned char channel, int speed) {
+    if (traceCapacity - traceLength < 32) {
+        traceCapacity = traceCapacity == 0 ? 65536 : traceCapacity * 2;
+        trace = realloc(trace, traceCapacity);
+    }
+    traceLength += snprintf(trace + traceLength, traceCapacity - traceLength, "%lu,%d,%d\n",
+        millis(), channel, speed);
+}
+
+void motorSet(unsigned char channel, int speed) {
+    if (channel < 1 || channel > MOTOR_PORTS)
+        return;
+    if (speed > 127)
+        speed = 127;
+    if (speed < -127)
+        speed = -127;
+    simRobot.motors[channel] = speed;
+    if (tracing)
+        traceMotor(channel, speed);
+}
+
+void motorStop(unsigned char channel) {
+    motorSet(channel, 0);
+}
+
+void motorStopAll() {
+    for (int port = 1; port <= MOTOR_PORTS; port++)
+        motorSet(port, 0);
+}
+
+// -------------------- Sensors --------------------
+
+// IME counts at the last imeReset(), by address
+static double imeZero[2];
+
+static double imeTicks(unsigned char address) {
+    return address == L_DRIVE_IME ? simRobot.leftTicks : simRobot.rightTicks;
+}
+
+unsigned int imeInitializeAll() {
+    return 2;
+}
+
+bool imeGet(unsigned char address, int *value) {
+    if (address != L_DRIVE_IME && address != R_DRIVE_IME)
+        return false;
+    *value = (int)(imeTicks(address) - imeZero[address]);
+    return true;
+}
+
+bool imeGetVelocity(unsigned char address, int *value) {
+    if (address != L_DRIVE_IME && address != R_DRIVE_IME)
+        return false;
+    double speed = address == L_DRIVE_IME ? simRobot.leftSpeed : simRobot.rightSpeed;
+    // Internal encoder wheel RPM of a 393 in high torque mode
+    *value = (int)(speed * 60 / 627.2 * 39.2);
+    return true;
+}
+
+bool imeReset(unsigned char address) {
+    if (address != L_DRIVE_IME && address != R_DRIVE_IME)
+        return false;
+    imeZero[address] = imeTicks(address);
+    return true;
+}
+
+void imeShutdown() {
+}
+
+// Gyro readings at the last gyroReset()
+static int gyroZero = 0;
+static int gyroHandle;
+
+Gyro gyroInit(unsigned char port, unsigned short multiplier) {
+    gyroReset(&gyroHandle);
+    return &gyroHandle;
+}
+
+int gyroGet(Gyro gyro) {
+    int degrees = physicsGyro() - gyroZero;
+    return degrees;
+}
+
+void gyroReset(Gyro gyro) {
+    gyroZero = physicsGyro();
+}
+
+void gyroShutdown(Gyro gyro) {
+}
+
+// The simulated robot has no quadrature encoders or ultrasonics
+Encoder encoderInit(unsigned char portTop, unsigned char portBottom, bool reverse) {
+    return NULL;
+}
+
+int encoderGet(Encoder enc) {
+    return 0;
+}
+
+void encoderReset(Encoder enc) {
+}
+
+void encoderShutdown(Encoder enc) {
+}
+
+Ultrasonic ultrasonicInit(unsigned char portEcho, unsigned char portPing) {
+    return NULL;
+}
+
+int ultrasonicGet(Ultrasonic ult) {
+    return ULTRA_BAD_RESPONSE;
+}
+
+void ultrasonicShutdown(Ultrasonic ult) {
+}
+
+// -------------------- Files and serial --------------------
+
+// Streams at or after this address are files from fopen(), before it are the serial ports
+#define FILE_SLOTS 8
+static PROS_FILE fileSlots[FILE_SLOTS];
+static int fileDescriptors[FILE_SLOTS];
+static bool fileEof[FILE_SLOTS];
+static const char *fileSystem = NULL;
+static const char *telemetryPath = NULL;
+
+void simSetFileSystem(const char *directory) {
+    fileSystem = directory;
+}
+
+void simSetTelemetry(const char *path) {
+    telemetryPath = path;
+}
+
+// Host file descriptor for a stream, or -1 for a discarded serial port
+static int descriptor(PROS_FILE *stream) {
+    if (stream == stdout)
+        return STDOUT_FILENO;
+    if (stream >= fileSlots && stream < fileSlots + FILE_SLOTS)
+        return fileDescriptors[stream - fileSlots];
+    return -1;
+}
+
+PROS_FILE *simOpenHost(const char *path, const char *mode) {
+    int slot = 0;
+    while (slot < FILE_SLOTS && fileDescriptors[slot] > 0)
+        slot++;
+    if (slot == FILE_SLOTS)
+        return NULL;
+
+    int flags = mode[0] == 'w' ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY;
+    int fd = open(path, flags, 0644);
+    if (fd < 0)
+        return NULL;
+    fileDescriptors[slot] = fd;
+    fileEof[slot] = false;
+    return &fileSlots[slot];
+}
+
+PROS_FILE *simTelemetryStream() {
+    return simOpenHost(telemetryPath != NULL ? telemetryPath : "/dev/null", "w");
+}
+
+PROS_FILE *fopen(const char *file, const char *mode) {
+    if (fileSystem == NULL)
+        return NULL;
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", fileSystem, file);
+    return simOpenHost(path, mode);
+}
+
+void fclose(PROS_FILE *stream) {
+    if (stream >= fileSlots && stream < fileSlots + FILE_SLOTS) {
+        close(fileDescriptors[stream - fileSlots]);
+        fileDescriptors[stream - fileSlots] = 0;
+    }
+}
+
+int fdelete(const char *file) {
+    if (fileSystem == NULL)
+        return -1;
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", fileSystem, file);
+    return unlink(path);
+}
+
+size_t fwrite(const void *ptr, size_t size, size_t count, PROS_FILE *stream) {
+    int fd = descriptor(stream);
+    if (fd < 0)
+        return count;
+    ssize_t written = write(fd, ptr, size * count);
+    return written < 0 || size == 0 ? 0 : (size_t)written / size;
+}
+
+size_t fread(void *ptr, size_t size, size_t count, PROS_FILE *stream) {
+    int fd = descriptor(stream);
+    if (fd < 0 || fd == STDOUT_FILENO || size == 0)
+        return 0;
+    ssize_t got = read(fd, ptr, size * count);
+    if (got <= 0) {
+        fileEof[stream - fileSlots] = true;
+        return 0;
+    }
+    return (size_t)got / size;
+}
+
+int fgetc(PROS_FILE *stream) {
+    unsigned char value;
+    return fread(&value, 1, 1, stream) == 1 ? value : EOF;
+}
+
+char *fgets(char *str, int num, PROS_FILE *stream) {
+    int length = 0;
+    while (length < num - 1) {
+        int value = fgetc(stream);
+        if (value == EOF)
+            break;
+        str[length++] = (char)value;
+        if (value == '\n')
+            break;
+    }
+    if (length == 0)
+        return NULL;
+    str[length] = '\0';
+    return str;
+}
+
+int feof(PROS_FILE *stream) {
+    if (stream >= fileSlots && stream < fileSlots + FILE_SLOTS)
+        return fileEof[stream - fileSlots];
+    return 0;
+}
+
+int fcount(PROS_FILE *stream) {
+    return 0;
+}
+
+int fflush(PROS_FILE *stream) {
+    return 0;
+}
+
+int fseek(PROS_FILE *stream, long int offset, int origin) {
+    int fd = descriptor(stream);
+    if (fd < 0 || fd == STDOUT_FILENO)
+        return -1;
+    return lseek(fd, offset, origin) < 0 ? -1 : 0;
+}
+
+long int ftell(PROS_FILE *stream) {
+    int fd = descriptor(stream);
+    if (fd < 0 || fd == STDOUT_FILENO)
+        return -1;
+    return lseek(fd, 0, SEEK_CUR);
+}
+
+int fputc(int value, PROS_FILE *stream) {
+    unsigned char byte = (unsigned char)value;
+    return fwrite(&byte, 1, 1, stream) == 1 ? value : EOF;
+}
+
+int fputs(const char *string, PROS_FILE *stream) {
+    fwrite(string, 1, strlen(string), stream);
+    return 0;
+}
+
+void fprint(const char *string, PROS_FILE *stream) {
+    fputs(string, stream);
+}
+
+void print(const char *string) {
+    fputs(string, stdout);
+}
+
+int putchar(int value) {
+    return fputc(value, stdout);
+}
+
+int puts(const char *string) {
+    fputs(string, stdout);
+    return fputc('\n', stdout);
+}
+
+int getchar() {
+    return EOF;
+}
+
+int fprintf(PROS_FILE *stream, const char *formatString, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, formatString);
+    int length = vsnprintf(buffer, sizeof(buffer), formatString, args);
+    va_end(args);
+    if (length > (int)sizeof(buffer) - 1)
+        length = sizeof(buffer) - 1;
+    if (length > 0)
+        fwrite(buffer, 1, length, stream);
+    return length;
+}
+
+int printf(const char *formatString, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, formatString);
+    int length = vsnprintf(buffer, sizeof(buffer), formatString, args);
+    va_end(args);
+    if (length > (int)sizeof(buffer) - 1)
+        length = sizeof(buffer) - 1;
+    if (length > 0)
+        fwrite(buffer, 1, length, stdout);
+    return length;
+}
+
+int snprintf(char *buffer, size_t limit, const char *formatString, ...) {
+    va_list args;
+    va_start(args, formatString);
+    int length = vsnprintf(buffer, limit, formatString, args);
+    va_end(args);
+    return length;
+}
+
+int sprintf(char *buffer, const char *formatString, ...) {
+    va_list args;
+    va_start(args, formatString);
+    int length = vsnprintf(buffer, 4096, formatString, args);
+    va_end(args);
+    return length;
+}
+
+void usartInit(PROS_FILE *usart, unsigned int baud, unsigned int flags) {
+}
+
+void usartShutdown(PROS_FILE *usart) {
+}
+
+// -------------------- LCD --------------------
+
+void lcdInit(PROS_FILE *lcdPort) {
+}
+
+void lcdShutdown(PROS_FILE *lcdPort) {
+}
+
+void lcdClear(PROS_FILE *lcdPort) {
+}
+
+void lcdSetBacklight(PROS_FILE *lcdPort, bool backlight) {
+}
+
+void lcdSetText(PROS_FILE *lcdPort, unsigned char line, const char *buffer) {
+}
+
+void lcdPrint(PROS_FILE *lcdPort, unsigned char line, const char *formatString, ...) {
+}
+
+unsigned int lcdReadButtons(PROS_FILE *lcdPort) {
+    return 0;
+}
+
+// -------------------- Everything else --------------------
+
+bool i2cRead(uint8_t addr, uint8_t *data, uint16_t count) {
+    return false;
+}
+
+bool i2cReadRegister(uint8_t addr, uint8_t reg, uint8_t *value, uint16_t count) {
+    return false;
+}
+
+bool i2cWrite(uint8_t addr, uint8_t *data, uint16_t count) {
+    return false;
+}
+
+bool i2cWriteRegister(uint8_t addr, uint8_t reg, uint16_t value) {
+    return false;
+}
+
+void speakerInit() {
+}
+
+void speakerPlayArray(const char * * songs) {
+}
+
+void speakerPlayRtttl(const char *song) {
+}
+
+void speakerShutdown() {
+}
+
+void watchdogInit() {
+}
+
+void standaloneModeEnable() {
+}
+
+// -------------------- Simulation control --------------------
+
+void simStart(unsigned int seed) {
+    now = 0;
+    nextPhysics = 0;
+    physicsInit(seed);
+    tasks[0].state = TASK_RUNNING;
+    tasks[0].started = true;
+    tasks[0].priority = TASK_PRIORITY_DEFAULT;
+    current = &tasks[0];
+}
+
+static void modeTask(void *mode) {
+    ((void (*)())mode)();
+}
+
+TaskHandle simRunMode(void (*mode)()) {
+    return taskCreate(modeTask, TASK_DEFAULT_STACK_SIZE, (void *)mode, TASK_PRIORITY_DEFAULT);
+}
+
+void simDisable(TaskHandle mode) {
+    // The kernel cuts the motors off without going through motorSet()
+    taskDelete(mode);
+    for (int port = 1; port <= MOTOR_PORTS; port++)
+        simRobot.motors[port] = 0;
+    simRobot.competition.enabled = false;
+}
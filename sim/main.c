@@ -0,0 +1,282 @@
+/** @file main.c
+ * @brief Command line entry point of the host simulation
+ *
+ * Boots the robot program the way the Cortex does, with initializeIO() and then initialize(),
+ * runs one competition mode for a while on the virtual clock, and prints where the robot ended
+ * up. With --runs, each run is a forked copy of the untouched program with its own physics seed,
+ * and one CSV line is printed per run, so routines can be swept over many slightly different
+ * robots at once.
+ *
+ * With --replay, driver control runs on the joysticks recorded in a joylog.h log, until the log
+ * runs out. Every motorSet() call is traced as an "ms,port,speed" line, which --trace saves and
+ * --golden compares against an earlier trace, exiting with status 1 at the first difference. That
+ * makes recorded driving a regression test of the driver control code.
+ *
+ * Telemetry the robot sends to stdout is written to the file given with --telemetry, or dropped,
+ * so the report and CSV stay plain text.
+ *
+ * Usage: robot-sim [--auto | --driver] [--time ms] [--left-side] [--fs directory]
+ *                  [--seed n] [--runs n] [--jobs n]
+ *                  [--replay log] [--trace file] [--golden file] [--telemetry file]
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+
+// How long the robot stays disabled at the end of a run, for the black box to save
+#define SIM_DISABLED_MS 500
+
+// Not declared anywhere else, since <sys/wait.h> clashes with API.h's wait()
+pid_t waitpid(pid_t pid, int *status, int options);
+
+typedef struct {
+    bool autonomous;
+    bool leftSide;
+    unsigned long duration;
+    unsigned int seed;
+    int runs;
+    int jobs;
+    // Joystick log to drive with, and where to save or compare the motor trace, or NULL
+    const char *replay;
+    const char *trace;
+    const char *golden;
+    bool timeGiven;
+} Options;
+
+static void usage() {
+    printf("usage: robot-sim [--auto | --driver] [--time ms] [--left-side] [--fs directory]\n"
+        "                 [--seed n] [--runs n] [--jobs n]\n"
+        "                 [--replay log] [--trace file] [--golden file] [--telemetry file]\n");
+    exit(2);
+}
+
+// Time the last match ended, before the robot was disabled
+static unsigned long matchEnd;
+// Where odometry thought the robot was as the last match ended
+static Pose matchPose;
+
+// Runs one simulated match and returns the robot's state at the end of it
+static SimRobot simulate(const Options *options, unsigned int seed) {
+    simStart(seed);
+    // The limit switch is pressed, reading LOW, on the left side of the bar
+    simRobot.digital[LIMIT_SWITCH] = !options->leftSide;
+
+    initializeIO();
+    initialize();
+
+    if (options->replay != NULL && !joylogReplay(simOpenHost(options->replay, "r"))) {
+        printf("%s is not a joystick log\n", options->replay);
+        exit(2);
+    }
+    if (options->trace != NULL || options->golden != NULL)
+        simTraceMotors();
+
+    simRobot.competition.autonomous = options->autonomous;
+    simRobot.competition.enabled = true;
+    simRobot.competition.online = true;
+    TaskHandle mode = simRunMode(options->autonomous ? autonomous : operatorControl);
+    if (options->replay != NULL && !options->timeGiven) {
+        while (joylogIsReplaying())
+            delay(SCHED_PERIOD_MS);
+    } else {
+        delay(options->duration);
+    }
+
+    // Report the robot as the match ended, then let the background tasks see it disabled
+    SimRobot end = simRobot;
+    matchEnd = millis();
+    odometryGet(&matchPose);
+    simDisable(mode);
+    delay(SIM_DISABLED_MS);
+    return end;
+}
+
+static int headingDegrees(const SimRobot *robot) {
+    return (int)lround(robot->heading * 180 / M_PI);
+}
+
+static void report(const SimRobot *robot) {
+    printf("time %lu ms\n", matchEnd);
+    printf("pose x %d y %d heading %d deg\n", (int)robot->x, (int)robot->y,
+        headingDegrees(robot));
+    printf("odometry x %ld y %ld heading %d deg\n", matchPose.x >> ODOMETRY_SHIFT,
+        matchPose.y >> ODOMETRY_SHIFT, odometryDegrees(matchPose.heading));
+    printf("drive ticks left %d right %d\n", (int)robot->leftTicks, (int)robot->rightTicks);
+    printf("upper lift left %d right %d\n", (int)robot->leftLift, (int)robot->rightLift);
+    printf("lower lift %d deg\n", (int)robot->lowerLift);
+    printf("motors");
+    for (int port = 1; port <= MOTOR_PORTS; port++)
+        printf(" %d", robot->motors[port]);
+    printf("\n");
+}
+
+// Reads a whole host file, returning NULL if it can't be read
+static char *readHostFile(const char *path, size_t *length) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    size_t capacity = 65536;
+    char *contents = malloc(capacity);
+    *length = 0;
+    ssize_t got;
+    while ((got = read(fd, contents + *length, capacity - *length)) > 0) {
+        *length += got;
+        if (*length == capacity) {
+            capacity *= 2;
+            contents = realloc(contents, capacity);
+        }
+    }
+    close(fd);
+    return contents;
+}
+
+// Length of the line at the start of text, without its newline
+static int lineLength(const char *text, size_t remaining) {
+    int length = 0;
+    while ((size_t)length < remaining && text[length] != '\n')
+        length++;
+    return length;
+}
+
+// Saves and checks the motor trace, returning false if it differs from the golden one
+static bool checkTrace(const Options *options) {
+    size_t length;
+    const char *trace = simMotorTrace(&length);
+    if (options->trace != NULL) {
+        int fd = open(options->trace, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || write(fd, trace, length) != (ssize_t)length)
+            printf("could not write %s\n", options->trace);
+        if (fd >= 0)
+            close(fd);
+    }
+    if (options->golden == NULL)
+        return true;
+
+    size_t goldenLength;
+    char *golden = readHostFile(options->golden, &goldenLength);
+    if (golden == NULL) {
+        printf("could not read %s\n", options->golden);
+        return false;
+    }
+    // Find the first line that differs
+    size_t lineStart = 0;
+    int line = 1;
+    size_t i = 0;
+    while (i < length && i < goldenLength && trace[i] == golden[i]) {
+        if (trace[i] == '\n') {
+            lineStart = i + 1;
+            line++;
+        }
+        i++;
+    }
+    if (i == length && i == goldenLength) {
+        printf("motor trace matches %s, %d commands\n", options->golden, line - 1);
+        free(golden);
+        return true;
+    }
+    printf("motor trace differs from %s at line %d\n", options->golden, line);
+    printf("  expected %.*s\n", lineLength(golden + lineStart, goldenLength - lineStart),
+        golden + lineStart);
+    printf("  got      %.*s\n", lineLength(trace + lineStart, length - lineStart),
+        trace + lineStart);
+    free(golden);
+    return false;
+}
+
+static void sweep(const Options *options) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    printf("run,seed,x,y,heading,leftLift,rightLift,lowerLift\n");
+
+    int running = 0;
+    for (int run = 0; run < options->runs; run++) {
+        if (running == options->jobs) {
+            waitpid(-1, NULL, 0);
+            running--;
+        }
+        unsigned int seed = options->seed + run;
+        pid_t child = fork();
+        if (child == 0) {
+            SimRobot robot = simulate(options, seed);
+            printf("%d,%u,%d,%d,%d,%d,%d,%d\n", run, seed, (int)robot.x, (int)robot.y,
+                headingDegrees(&robot), (int)robot.leftLift, (int)robot.rightLift,
+                (int)robot.lowerLift);
+            _exit(0);
+        }
+        if (child > 0)
+            running++;
+    }
+    while (running-- > 0)
+        waitpid(-1, NULL, 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    char summary[128];
+    int length = snprintf(summary, sizeof(summary), "%d runs in %d ms, %d runs per second\n",
+        options->runs, (int)(seconds * 1000), (int)(options->runs / seconds));
+    write(STDERR_FILENO, summary, length);
+}
+
+int main(int argc, char **argv) {
+    Options options = {true, false, 15000, 0, 1, 1, NULL, NULL, NULL, false};
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--auto") == 0)
+            options.autonomous = true;
+        else if (strcmp(argv[i], "--driver") == 0)
+            options.autonomous = false;
+        else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            options.duration = strtoul(argv[++i], NULL, 10);
+            options.timeGiven = true;
+        }
+        else if (strcmp(argv[i], "--left-side") == 0)
+            options.leftSide = true;
+        else if (strcmp(argv[i], "--fs") == 0 && i + 1 < argc)
+            simSetFileSystem(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            options.seed = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+            options.runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+            options.jobs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options.replay = argv[++i];
+            options.autonomous = false;
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            options.trace = argv[++i];
+        else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+            options.golden = argv[++i];
+        else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc)
+            simSetTelemetry(argv[++i]);
+        else
+            usage();
+    }
+    if (options.runs < 1 || options.jobs < 1)
+        usage();
+
+    if (options.runs > 1) {
+        sweep(&options);
+    } else {
+        struct timespec start, end;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+        SimRobot robot = simulate(&options, options.seed);
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+        report(&robot);
+        if (options.replay != NULL) {
+            // Host time, so the physics model is included, but it shows which inputs cost most
+            double micros = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+            unsigned long ticks = matchEnd / SCHED_PERIOD_MS;
+            printf("replayed %lu ticks, %d us of host cpu per tick\n", ticks,
+                (int)(micros / (ticks > 0 ? ticks : 1)));
+        }
+        if (!checkTrace(&options))
+            _exit(1);
+    }
+    _exit(0);
+}
@@ -0,0 +1,151 @@
+/** @file physics.c
+ * @brief Simple physics model of the drive and lifts for the host simulation
+ *
+ * Each motor side is a first order system: its speed approaches the commanded fraction of its
+ * top speed with a fixed time constant. The upper lift sides sag under gravity when unpowered,
+ * and the right side is slightly weaker so the two drift apart unless they are synced. A non-zero
+ * seed scales each motor side's strength and the battery by a few percent, so sweeps can check
+ * that a routine holds up on a robot that isn't quite the nominal one.
+ */
+
+#include <math.h>
+#include "sim.h"
+
+#define DT (SIM_PHYSICS_PERIOD_US / 1000000.0)
+
+// Drive top speed in IME ticks per second, and how quickly it is reached
+#define DRIVE_TOP_SPEED 1050.0
+#define DRIVE_TIME_CONSTANT 0.15
+// Distance between the wheels in IME ticks
+#define TRACK_WIDTH 900.0
+
+// Upper lift top speed in potentiometer counts per second, and its sag when unpowered
+#define LIFT_TOP_SPEED 1400.0
+#define LIFT_SAG_SPEED 120.0
+#define LIFT_RIGHT_STRENGTH 0.9
+#define LEFT_LIFT_TOP 2000.0
+#define RIGHT_LIFT_TOP 1720.0
+
+// Lower lift top speed in degrees per second
+#define LOWER_LIFT_TOP_SPEED 90.0
+#define LOWER_LIFT_TOP 110.0
+
+// Raw potentiometer readings with the lift at the bottom
+#define POTENT_BASE 180
+
+// Battery voltage with nothing running, and the drop per unit of motor output
+#define BATTERY_REST 8200
+#define BATTERY_SAG 1.2
+
+// Largest fraction a seeded robot's strengths and battery are varied by
+#define VARIATION 0.05
+
+SimRobot simRobot;
+
+// Deterministic sensor noise
+static unsigned int noiseState;
+
+// Strength of each mechanism relative to nominal
+static double leftDriveStrength;
+static double rightDriveStrength;
+static double leftLiftStrength;
+static double rightLiftStrength;
+static double batteryRest;
+
+static unsigned int nextRandom() {
+    noiseState = noiseState * 1103515245 + 12345;
+    return noiseState >> 16;
+}
+
+static int noise() {
+    return (int)(nextRandom() % 7) - 3;
+}
+
+// A factor within VARIATION of 1
+static double vary() {
+    return 1 + VARIATION * ((int)(nextRandom() % 2001) - 1000) / 1000.0;
+}
+
+void physicsInit(unsigned int seed) {
+    SimRobot empty = {0};
+    simRobot = empty;
+    for (int pin = 1; pin <= BOARD_NR_GPIO_PINS; pin++)
+        simRobot.digital[pin] = true;
+
+    noiseState = 12345 + seed;
+    leftDriveStrength = seed != 0 ? vary() : 1;
+    rightDriveStrength = seed != 0 ? vary() : 1;
+    leftLiftStrength = seed != 0 ? vary() : 1;
+    rightLiftStrength = (seed != 0 ? vary() : 1) * LIFT_RIGHT_STRENGTH;
+    batteryRest = (seed != 0 ? vary() : 1) * BATTERY_REST;
+    simRobot.battery = (unsigned int)batteryRest;
+}
+
+static double command(int port) {
+    int speed = simRobot.motors[port];
+    if (speed > 127)
+        speed = 127;
+    if (speed < -127)
+        speed = -127;
+    return speed / 127.0;
+}
+
+static double clamp(double value, double low, double high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+static double lift(double position, double power, double strength, double top) {
+    double speed = power * LIFT_TOP_SPEED * strength;
+    // Unpowered or weakly powered sides sink under their own weight
+    if (fabs(power) < 0.15)
+        speed -= LIFT_SAG_SPEED;
+    return clamp(position + speed * DT, 0, top);
+}
+
+void physicsStep() {
+    SimRobot *robot = &simRobot;
+
+    // Drive sides approach their commanded speeds
+    double alpha = DT / DRIVE_TIME_CONSTANT;
+    double leftTarget = command(L_DRIVE) * DRIVE_TOP_SPEED * leftDriveStrength;
+    double rightTarget = command(R_DRIVE) * DRIVE_TOP_SPEED * rightDriveStrength;
+    robot->leftSpeed += (leftTarget - robot->leftSpeed) * alpha;
+    robot->rightSpeed += (rightTarget - robot->rightSpeed) * alpha;
+    robot->leftTicks += robot->leftSpeed * DT;
+    robot->rightTicks += robot->rightSpeed * DT;
+
+    double forward = (robot->leftSpeed + robot->rightSpeed) / 2 * DT;
+    robot->heading += (robot->rightSpeed - robot->leftSpeed) / TRACK_WIDTH * DT;
+    robot->x += forward * cos(robot->heading);
+    robot->y += forward * sin(robot->heading);
+
+    robot->leftLift = lift(robot->leftLift, command(UPPER_LIFT_L), leftLiftStrength,
+        LEFT_LIFT_TOP);
+    robot->rightLift = lift(robot->rightLift, command(UPPER_LIFT_R), rightLiftStrength,
+        RIGHT_LIFT_TOP);
+
+    // LOWER_LIFT_R is mounted backwards
+    double lowerPower = (command(LOWER_LIFT_L) - command(LOWER_LIFT_R)) / 2;
+    robot->lowerLift = clamp(robot->lowerLift + lowerPower * LOWER_LIFT_TOP_SPEED * DT, 0,
+        LOWER_LIFT_TOP);
+
+    double load = 0;
+    for (int port = 1; port <= MOTOR_PORTS; port++)
+        load += fabs(command(port)) * 127;
+    robot->battery = (unsigned int)(batteryRest - load * BATTERY_SAG);
+}
+
+int physicsAnalog(unsigned char channel) {
+    switch (channel) {
+    case LEFT_POTENT:
+        return POTENT_BASE + (int)simRobot.leftLift + noise();
+    case RIGHT_POTENT:
+        return POTENT_BASE + (int)simRobot.rightLift + noise();
+    default:
+        return 0;
+    }
+}
+
+int physicsGyro() {
+    return (int)lround(simRobot.heading * 180 / M_PI);
+}
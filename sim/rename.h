@@ -0,0 +1,33 @@
+/** @file rename.h
+ * @brief Renames the API.h functions that share names with the host C library
+ *
+ * Force-included into every file of the simulation build, so API.h declares sim_printf() and
+ * friends and the robot program links against the simulation instead of the host's stdio.
+ * No simulation file may include <stdio.h>.
+ */
+
+#ifndef SIM_RENAME_H_
+#define SIM_RENAME_H_
+
+#define fclose sim_fclose
+#define feof sim_feof
+#define fflush sim_fflush
+#define fgetc sim_fgetc
+#define fgets sim_fgets
+#define fopen sim_fopen
+#define fprintf sim_fprintf
+#define fputc sim_fputc
+#define fputs sim_fputs
+#define fread sim_fread
+#define fseek sim_fseek
+#define ftell sim_ftell
+#define fwrite sim_fwrite
+#define getchar sim_getchar
+#define printf sim_printf
+#define putchar sim_putchar
+#define puts sim_puts
+#define snprintf sim_snprintf
+#define sprintf sim_sprintf
+#define wait sim_wait
+
+#endif
@@ -0,0 +1,134 @@
+/** @file sim.h
+ * @brief Header file shared by the host simulation of the VEX Cortex
+ *
+ * The simulation implements the API.h surface on a Linux host so the robot program in src/ can
+ * run without a robot. api.c provides the PROS functions, physics.c models the drive and lifts,
+ * and main.c runs a competition mode from the command line.
+ *
+ * Only one simulated task runs at a time and time only moves while every task is blocked, so
+ * the simulation state needs no locking.
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include "main.h"
+
+// Physics update period in microseconds
+#define SIM_PHYSICS_PERIOD_US 1000
+
+// Competition state reported by isAutonomous(), isEnabled() and isOnline()
+typedef struct {
+    bool autonomous;
+    bool enabled;
+    bool online;
+} SimCompetition;
+
+// Joystick state, analog axes 1 to 4 and button groups 5 to 8 of both joysticks
+typedef struct {
+    signed char analog[2][4];
+    unsigned char digital[2][4];
+} SimJoystick;
+
+typedef struct {
+    // Raw motorSet() values, indexed by port
+    int motors[MOTOR_PORTS + 1];
+
+    // Drive, positions in IME ticks and speeds in ticks per second
+    double leftTicks;
+    double rightTicks;
+    double leftSpeed;
+    double rightSpeed;
+    // Pose in ticks and radians, counterclockwise positive
+    double x;
+    double y;
+    double heading;
+
+    // Upper lift sides in raw potentiometer counts above the bottom
+    double leftLift;
+    double rightLift;
+    // Lower lift in degrees above the bottom, which has no sensor
+    double lowerLift;
+
+    // Main battery in millivolts
+    unsigned int battery;
+    // Digital inputs, true being HIGH
+    bool digital[BOARD_NR_GPIO_PINS + 1];
+    SimJoystick joystick;
+    SimCompetition competition;
+} SimRobot;
+
+extern SimRobot simRobot;
+
+/**
+ * Puts the robot at rest at the origin with the lifts down.
+ *
+ * @param seed 0 for the nominal robot, anything else for a robot whose motor strengths, battery
+ * and sensor noise are varied by a few percent, the same way for the same seed
+ */
+void physicsInit(unsigned int seed);
+/**
+ * Advances the model by one SIM_PHYSICS_PERIOD_US step.
+ */
+void physicsStep();
+/**
+ * Returns the raw 12-bit reading of an analog channel, including sensor noise.
+ */
+int physicsAnalog(unsigned char channel);
+/**
+ * Returns the gyro reading in degrees.
+ */
+int physicsGyro();
+
+/**
+ * Resets the virtual clock to zero and the robot to its starting state. The caller becomes the
+ * first simulated task.
+ *
+ * @param seed passed to physicsInit()
+ */
+void simStart(unsigned int seed);
+/**
+ * Sets the directory that fopen() reads and writes, or NULL for an empty file system.
+ */
+void simSetFileSystem(const char *directory);
+/**
+ * Sets the host file that telemetry started on stdout is written to, or NULL to discard it.
+ */
+void simSetTelemetry(const char *path);
+/**
+ * Opens the telemetry file set by simSetTelemetry(), or a stream that discards everything.
+ */
+PROS_FILE *simTelemetryStream();
+/**
+ * Opens a file on the host, by its host path, as a PROS stream.
+ *
+ * @return the stream, or NULL if it could not be opened
+ */
+PROS_FILE *simOpenHost(const char *path, const char *mode);
+/**
+ * Starts recording every motorSet() call, clearing anything recorded before.
+ */
+void simTraceMotors();
+/**
+ * Returns the motorSet() calls recorded since simTraceMotors(), one "ms,port,speed" line each.
+ */
+const char *simMotorTrace(size_t *length);
+/**
+ * Returns host time in cycles of the Cortex's clock, for the profiler.
+ */
+unsigned long simCycles();
+/**
+ * Changes a digital input, running its interrupt handler if the edge is one it watches.
+ */
+void simSetDigital(unsigned char pin, bool value);
+/**
+ * Creates the task that runs a competition mode.
+ */
+TaskHandle simRunMode(void (*mode)());
+/**
+ * Disables the robot the way the field does, stopping the competition mode's task and every
+ * motor, so the tasks started by initialize() see the end of the match.
+ */
+void simDisable(TaskHandle mode);
+
+#endif
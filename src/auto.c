@@ -12,72 +12,100 @@
 
 #include "main.h"
 
-void setDrive(int speed, int duration);
-void spinLeft(int duration);
-void spinRight(int duration);
-void lowerLLift(int duration);
-void raiseLLift(int duration);
+// Distances are in drive IME ticks (627.2 per wheel turn on 393 motors in high torque mode)
+// Roughly what the old 5.7 second full power drive covered
+#define CONE_DISTANCE 5900
+#define RETURN_DISTANCE -6500
+#define BACK_AWAY_DISTANCE -1100
+#define SPIN_DEGREES 15
 
-void autonomous() {
+// Longest any single move may take before it is abandoned
+#define MOVE_TIMEOUT 9000
+
+// Script on the Cortex file system that replaces the compiled-in routine when present
+#define AUTO_SCRIPT_FILE "auto"
 
-    // By default, we are on the right side of the bar
-    int rightSide = 1;
-    if (digitalRead(LIMIT_SWITCH) == LOW) {
-        // if the limit switch is pressed, we are on the left side of the bar
-        rightSide = 0;
-    }
-
-    // Move forward to get under the cone
-    setDrive(127, 5700);
-    /*
-    // Raise the lift while under the cone
-    raiseLLift(1300);
-    // Spin just a tad
-    if (rightSide) {
-        spinRight(240);
-    } else {
-        spinLeft(240);
-    }
+// Move forward to get under the cone
+const unsigned char coneRoutine[] = {
+    SCRIPT_DRIVE(CONE_DISTANCE, 127, MOVE_TIMEOUT),
+    SCRIPT_END(),
+};
+
+// Get under the cone, lift it and bring it back to the start
+const unsigned char coneReturnRoutine[] = {
+    SCRIPT_DRIVE(CONE_DISTANCE, 127, MOVE_TIMEOUT),
+    // Raise the lift while under the cone, and spin just a tad while it goes up
+    SCRIPT_PARALLEL(),
+    SCRIPT_LOWER_LIFT(127, 1300),
+    // The limit switch is pressed when we are on the left side of the bar
+    SCRIPT_JUMP_IF_DIGITAL(LIMIT_SWITCH, LOW, SCRIPT_SIZE_TURN + SCRIPT_SIZE_JUMP),
+    SCRIPT_TURN(-SPIN_DEGREES, MOVE_TIMEOUT),
+    SCRIPT_JUMP(SCRIPT_SIZE_TURN),
+    SCRIPT_TURN(SPIN_DEGREES, MOVE_TIMEOUT),
+    SCRIPT_JOIN(),
     // Drive back to start
-    setDrive(-127, 6300);
+    SCRIPT_DRIVE(RETURN_DISTANCE, 127, MOVE_TIMEOUT),
     // Lower the lift
-    lowerLLift(880);
+    SCRIPT_LOWER_LIFT(-100, 880),
     // Move back away from dropped cone
-    setDrive(-127, 1100);*/
-}
+    SCRIPT_DRIVE(BACK_AWAY_DISTANCE, 127, MOVE_TIMEOUT),
+    SCRIPT_END(),
+};
+
+typedef struct {
+    const unsigned char *code;
+    int length;
+} AutoRoutine;
+
+const AutoRoutine autoRoutines[] = {
+    {coneRoutine, sizeof(coneRoutine)},
+    {coneReturnRoutine, sizeof(coneReturnRoutine)},
+};
+
+// Compiled-in routine to run when there is no script file
+int autoRoutine = 0;
+
+// AUTO_SCRIPT_FILE as read at boot, so autonomous starts without touching flash
+static unsigned char fileScript[SCRIPT_MAX_BYTES];
+static int fileScriptLength = 0;
 
-void setDrive(int speed, int duration) {
-    motorSet(L_DRIVE, speed);
-    motorSet(R_DRIVE, speed);
- 	delay(duration);
- 	motorStop(L_DRIVE);
- 	motorStop(R_DRIVE);
+void autonomousStart();
+void autonomousCheckDone();
+void autonomousHoldLift();
+
+const Behavior autonomousBehavior = {"autonomous", autonomousStart};
+
+// The runtime runs the routine, so this task has nothing left to do and can end
+void autonomous() {
+    runtimeSetBehavior(&autonomousBehavior);
 }
-void spinLeft(int duration) {
-    motorSet(L_DRIVE, -127);
-    motorSet(R_DRIVE, 127);
-    delay(duration);
-    motorStop(L_DRIVE);
-    motorStop(R_DRIVE);
+
+void autonomousPrepare() {
+    fileScriptLength = scriptReadFile(AUTO_SCRIPT_FILE, fileScript);
 }
-void spinRight(int duration) {
-    motorSet(L_DRIVE, 127);
-    motorSet(R_DRIVE, -127);
-    delay(duration);
-    motorStop(L_DRIVE);
-    motorStop(R_DRIVE);
+
+// Sets up the scheduler with everything autonomous runs each tick
+void autonomousStart() {
+    if (fileScriptLength > 0)
+        scriptLoad(fileScript, fileScriptLength);
+    else
+        scriptLoad(autoRoutines[autoRoutine].code, autoRoutines[autoRoutine].length);
+
+    schedulerRegister(scriptStep, SCHED_HIGH);
+    schedulerRegister(motionUpdate, SCHED_HIGH);
+    // After motionUpdate(), so a lift primitive that just finished is held on the same tick
+    schedulerRegister(autonomousHoldLift, SCHED_HIGH);
+    schedulerRegister(autonomousCheckDone, SCHED_HIGH);
 }
-void lowerLLift(int duration) {
-    motorSet(LOWER_LIFT_L, -100);
-    motorSet(LOWER_LIFT_R, -100 * -1);
-    delay(duration);
-    motorStop(LOWER_LIFT_L);
-    motorStop(LOWER_LIFT_R);
+
+// Keeps the upper lift, and whatever it carries, where the last lift primitive left it
+void autonomousHoldLift() {
+    if (!motionIsBusy(MOTION_UPPER_LIFT))
+        liftHold();
 }
-void raiseLLift(int duration) {
-    motorSet(LOWER_LIFT_L, 127);
-    motorSet(LOWER_LIFT_R, 127 * -1);
-    delay(duration);
-    motorStop(LOWER_LIFT_L);
-    motorStop(LOWER_LIFT_R);
+
+// Goes back to whatever ran before, idle in a match or driver control while debugging
+void autonomousCheckDone() {
+    if (!scriptIsRunning())
+        runtimeFinish();
 }
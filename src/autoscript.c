@@ -0,0 +1,164 @@
+/** @file autoscript.c
+ * @brief Autonomous script interpreter
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Bytes of arguments after each opcode, indexed by opcode
+static const unsigned char argBytes[] = {
+    [OP_END] = 0,
+    [OP_DRIVE] = 6,
+    [OP_TURN] = 4,
+    [OP_LIFT] = 4,
+    [OP_LOWER_LIFT] = 4,
+    [OP_WAIT] = 2,
+    [OP_PARALLEL] = 0,
+    [OP_JOIN] = 0,
+    [OP_JUMP] = 2,
+    [OP_JUMP_IF_DIGITAL] = 6,
+};
+#define NUM_OPCODES (sizeof(argBytes) / sizeof(argBytes[0]))
+
+static const unsigned char *code = NULL;
+static int length = 0;
+static int pc = 0;
+static bool running = false;
+
+static bool parallel = false;
+// Motion channels the current instruction or parallel group is waiting for, bit per channel
+static unsigned int waitingFor = 0;
+// millis() at which an OP_WAIT ends, 0 if not waiting
+static unsigned long waitEnd = 0;
+
+void scriptLoad(const unsigned char *script, int scriptLength) {
+    code = script;
+    length = scriptLength;
+    pc = 0;
+    running = scriptLength > 0;
+    parallel = false;
+    waitingFor = 0;
+    waitEnd = 0;
+}
+
+int scriptReadFile(const char *name, unsigned char *buffer) {
+    PROS_FILE *file = fopen(name, "r");
+    if (file == NULL)
+        return 0;
+    int read = fread(buffer, 1, SCRIPT_MAX_BYTES, file);
+    fclose(file);
+    return read > 0 ? read : 0;
+}
+
+bool scriptIsRunning() {
+    return running;
+}
+
+static int arg(int index) {
+    return (short)(code[pc + 1 + index * 2] | (code[pc + 2 + index * 2] << 8));
+}
+
+static unsigned int argUnsigned(int index) {
+    return (unsigned short)arg(index);
+}
+
+// True once nothing the script is waiting on is still going
+static bool readyForNext() {
+    if (waitEnd != 0) {
+        if ((long)(millis() - waitEnd) < 0)
+            return false;
+        waitEnd = 0;
+    }
+    // Motions started inside a parallel group are only waited for at the join
+    if (parallel)
+        return true;
+    for (int channel = 0; channel < MOTION_CHANNELS; channel++) {
+        if ((waitingFor & (1 << channel)) && motionIsBusy(channel))
+            return false;
+    }
+    waitingFor = 0;
+    return true;
+}
+
+static void startedMotion(MotionChannel channel) {
+    waitingFor |= 1 << channel;
+}
+
+// Runs the instruction at pc and moves pc past it. Returns false when the script should stop.
+static bool execute() {
+    unsigned char op = code[pc];
+    if (op >= NUM_OPCODES || pc + 1 + argBytes[op] > length)
+        return false;
+    int next = pc + 1 + argBytes[op];
+
+    switch (op) {
+    case OP_END:
+        return false;
+    case OP_DRIVE:
+        motionDriveDistance(arg(0), arg(1), argUnsigned(2));
+        startedMotion(MOTION_DRIVE);
+        break;
+    case OP_TURN:
+        motionTurnTo(arg(0), argUnsigned(1));
+        startedMotion(MOTION_DRIVE);
+        break;
+    case OP_LIFT:
+        motionLiftTo(arg(0) * POTENT_ONE / 1000, argUnsigned(1));
+        startedMotion(MOTION_UPPER_LIFT);
+        break;
+    case OP_LOWER_LIFT:
+        motionLowerLiftFor(arg(0), argUnsigned(1));
+        startedMotion(MOTION_LOWER_LIFT);
+        break;
+    case OP_WAIT:
+        // Never 0, since 0 means not waiting
+        waitEnd = (millis() + argUnsigned(0)) | 1;
+        break;
+    case OP_PARALLEL:
+        parallel = true;
+        break;
+    case OP_JOIN:
+        parallel = false;
+        break;
+    case OP_JUMP:
+        next += arg(0);
+        break;
+    case OP_JUMP_IF_DIGITAL: {
+        // Scripts from the file system can hold anything, so a bad pin ends the script like a
+        // bad jump does
+        int pin = arg(0);
+        if (pin < 1 || pin > SENSOR_DIGITAL_PINS)
+            return false;
+        // Watched pins are debounced by the event queue, dispatched at the start of this tick
+        bool level;
+        if (eventsIsWatched(pin)) {
+            level = eventsLevel(pin);
+        } else {
+            SensorFrame sensors;
+            sensorsGet(&sensors);
+            level = sensorDigital(&sensors, pin);
+        }
+        if ((int)level == arg(1))
+            next += arg(2);
+        break;
+    }
+    }
+
+    if (next < 0 || next > length)
+        return false;
+    pc = next;
+    return true;
+}
+
+void scriptStep() {
+    for (int steps = 0; running && steps < SCRIPT_MAX_STEPS_PER_TICK; steps++) {
+        if (!readyForNext())
+            return;
+        if (pc >= length || !execute()) {
+            running = false;
+            return;
+        }
+    }
+}
@@ -0,0 +1,179 @@
+/** @file blackbox.c
+ * @brief Black box match recorder
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+typedef struct {
+    unsigned long time;
+    short analog[BLACKBOX_ANALOG];
+    unsigned short digital;
+    int ime[SENSOR_IMES];
+    short gyro;
+    signed char motors[MOTOR_PORTS];
+    unsigned char state;
+    unsigned short battery;
+    unsigned short backup;
+} BlackboxSample;
+
+static BlackboxSample ring[BLACKBOX_SAMPLES];
+// Samples ever recorded since the ring was last written out
+static volatile unsigned long head = 0;
+static int ticksUntilSample = 0;
+
+// Set by the first fault, and the sample count at which recording stops for it
+static volatile bool faulted = false;
+static BlackboxReason faultReason;
+static unsigned long freezeAt;
+static volatile bool frozen = false;
+
+static TaskHandle blackboxTask = NULL;
+
+void blackboxFault(BlackboxReason reason) {
+    if (faulted)
+        return;
+    faultReason = reason;
+    freezeAt = head + BLACKBOX_SAMPLES / 2;
+    faulted = true;
+}
+
+void blackboxRecord() {
+    // The control loop keeps running while disabled, but matches are recorded from enable on
+    if (frozen || !isEnabled() || --ticksUntilSample > 0)
+        return;
+    ticksUntilSample = BLACKBOX_TICKS_PER_SAMPLE;
+
+    SensorFrame sensors;
+    sensorsGet(&sensors);
+    BlackboxSample *sample = &ring[head % BLACKBOX_SAMPLES];
+
+    sample->time = millis();
+    for (int i = 0; i < BLACKBOX_ANALOG; i++)
+        sample->analog[i] = sensors.analog[i + 1];
+    sample->digital = sensors.digital;
+    for (int i = 0; i < SENSOR_IMES; i++)
+        sample->ime[i] = sensors.ime[i];
+    sample->gyro = sensors.gyro;
+    for (int port = 1; port <= MOTOR_PORTS; port++)
+        sample->motors[port - 1] = motorFrameGet(port);
+
+    unsigned char state = 0;
+    if (isEnabled())
+        state |= BLACKBOX_ENABLED;
+    if (isAutonomous())
+        state |= BLACKBOX_AUTONOMOUS;
+    if (isOnline())
+        state |= BLACKBOX_ONLINE;
+    if (schedulerIsDegraded())
+        state |= BLACKBOX_DEGRADED;
+    sample->state = state;
+    sample->battery = powerLevelMain();
+    sample->backup = powerLevelBackup();
+    head++;
+
+    if (state & BLACKBOX_DEGRADED)
+        blackboxFault(BLACKBOX_REASON_OVERRUN);
+    // A dead battery reads as 0, which is not a brownout
+    if (sample->battery > 0 && sample->battery < BLACKBOX_LOW_BATTERY_MV)
+        blackboxFault(BLACKBOX_REASON_LOW_BATTERY);
+    if (faulted && head >= freezeAt)
+        frozen = true;
+}
+
+// The sample's fields in file order
+static void sampleFields(const BlackboxSample *sample, long *fields) {
+    int n = 0;
+    fields[n++] = sample->time;
+    for (int i = 0; i < BLACKBOX_ANALOG; i++)
+        fields[n++] = sample->analog[i];
+    fields[n++] = sample->digital;
+    for (int i = 0; i < SENSOR_IMES; i++)
+        fields[n++] = sample->ime[i];
+    fields[n++] = sample->gyro;
+    for (int i = 0; i < MOTOR_PORTS; i++)
+        fields[n++] = sample->motors[i];
+    fields[n++] = sample->state;
+    fields[n++] = sample->battery;
+    fields[n++] = sample->backup;
+}
+
+// Writes a signed value as a zigzag varint, returning the number of bytes used
+static int putVarint(unsigned char *out, long value) {
+    unsigned long zigzag = ((unsigned long)value << 1) ^ (unsigned long)(value >> 31);
+    int length = 0;
+    while (zigzag >= 0x80) {
+        out[length++] = (unsigned char)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    out[length++] = (unsigned char)zigzag;
+    return length;
+}
+
+static void save(const char *file, BlackboxReason reason) {
+    unsigned long count = head < BLACKBOX_SAMPLES ? head : BLACKBOX_SAMPLES;
+    if (count == 0)
+        return;
+    PROS_FILE *stream = fopen(file, "w");
+    if (stream == NULL)
+        return;
+
+    unsigned char header[BLACKBOX_HEADER_BYTES] = {'B', 'B', BLACKBOX_VERSION, reason,
+        SCHED_PERIOD_MS * BLACKBOX_TICKS_PER_SAMPLE, count & 0xFF, count >> 8, BLACKBOX_FIELDS};
+    fwrite(header, 1, sizeof(header), stream);
+
+    long previous[BLACKBOX_FIELDS] = {0};
+    for (unsigned long i = head - count; i != head; i++) {
+        long fields[BLACKBOX_FIELDS];
+        sampleFields(&ring[i % BLACKBOX_SAMPLES], fields);
+
+        unsigned char out[BLACKBOX_MAX_SAMPLE_BYTES];
+        int length = 3;
+        unsigned long mask = 0;
+        for (int field = 0; field < BLACKBOX_FIELDS; field++) {
+            if (fields[field] != previous[field]) {
+                mask |= 1UL << field;
+                length += putVarint(&out[length], fields[field] - previous[field]);
+                previous[field] = fields[field];
+            }
+        }
+        out[0] = mask;
+        out[1] = mask >> 8;
+        out[2] = mask >> 16;
+        fwrite(out, 1, length, stream);
+    }
+    fclose(stream);
+}
+
+static void blackboxLoop(void *ignore) {
+    bool wasEnabled = isEnabled();
+    bool wasAutonomous = isAutonomous();
+    while (1) {
+        bool enabled = isEnabled();
+        if (wasEnabled && !enabled) {
+            // blackboxRecord() stops recording once disabled, so nothing else touches the ring now
+            frozen = true;
+            if (faulted)
+                save(BLACKBOX_FAULT_FILE, faultReason);
+            else
+                save(wasAutonomous ? BLACKBOX_AUTO_FILE : BLACKBOX_DRIVE_FILE,
+                    BLACKBOX_REASON_DISABLED);
+            head = 0;
+            ticksUntilSample = 0;
+            faulted = false;
+            frozen = false;
+        }
+        wasEnabled = enabled;
+        wasAutonomous = isAutonomous();
+        delay(BLACKBOX_WATCH_MS);
+    }
+}
+
+void blackboxStart() {
+    if (blackboxTask != NULL)
+        return;
+    blackboxTask = taskCreate(blackboxLoop, TASK_DEFAULT_STACK_SIZE, NULL,
+        BLACKBOX_TASK_PRIORITY);
+}
@@ -0,0 +1,62 @@
+/** @file drivemix.c
+ * @brief Drive mixer
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+static int clampInput(int value) {
+    if (value > MOTOR_MAX_SPEED)
+        return MOTOR_MAX_SPEED;
+    if (value < -MOTOR_MAX_SPEED)
+        return -MOTOR_MAX_SPEED;
+    return value;
+}
+
+void driveMix(DriveMode mode, int first, int second, int *left, int *right) {
+    first = clampInput(first);
+    second = clampInput(second);
+
+    int l;
+    int r;
+    switch (mode) {
+    case DRIVE_ARCADE:
+        l = first + second;
+        r = first - second;
+        break;
+    case DRIVE_CURVATURE: {
+        int throttle = abs(first);
+        int turn = throttle * second / MOTOR_MAX_SPEED;
+        // Fades into turning in place as the throttle drops, so there's no step at the threshold
+        if (throttle < DRIVE_QUICK_TURN_THROTTLE)
+            turn += (second - turn) * (DRIVE_QUICK_TURN_THROTTLE - throttle) /
+                DRIVE_QUICK_TURN_THROTTLE;
+        l = first + turn;
+        r = first - turn;
+        break;
+    }
+    default:
+        l = first;
+        r = second;
+        break;
+    }
+
+    // Scale both sides down together so the faster one is at full power
+    int largest = abs(l) > abs(r) ? abs(l) : abs(r);
+    if (largest > MOTOR_MAX_SPEED) {
+        l = l * MOTOR_MAX_SPEED / largest;
+        r = r * MOTOR_MAX_SPEED / largest;
+    }
+    *left = l;
+    *right = r;
+}
+
+void driveMixSet(DriveMode mode, int first, int second) {
+    int left;
+    int right;
+    driveMix(mode, first, second, &left, &right);
+    motorFrameSet(L_DRIVE, left);
+    motorFrameSet(R_DRIVE, right);
+}
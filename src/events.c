@@ -0,0 +1,134 @@
+/** @file events.c
+ * @brief Interrupt-driven digital input events
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Pin 10 can't raise interrupts on the Cortex
+#define EVENT_NO_INTERRUPT_PIN 10
+
+typedef struct {
+    unsigned long time;
+    unsigned char pin;
+    bool level;
+} Edge;
+
+typedef struct {
+    bool watched;
+    bool level;
+    unsigned long debounce;
+    unsigned long lastChange;
+    unsigned long rising;
+    unsigned long falling;
+    EventCallback callback;
+} PinState;
+
+static Edge queue[EVENT_QUEUE_SIZE];
+// Edges ever queued and handled. Only the interrupt handler moves head, only dispatch moves tail.
+static volatile unsigned long head = 0;
+static volatile unsigned long tail = 0;
+static volatile unsigned long dropped = 0;
+
+static PinState pins[SENSOR_DIGITAL_PINS + 1];
+
+// Runs in the interrupt, so it does no more than record the edge
+static void onEdge(unsigned char pin) {
+    unsigned long next = head;
+    if (next - tail >= EVENT_QUEUE_SIZE) {
+        dropped++;
+        return;
+    }
+    Edge *edge = &queue[next % EVENT_QUEUE_SIZE];
+    edge->time = micros();
+    edge->pin = pin;
+    edge->level = digitalRead(pin);
+    __sync_synchronize();
+    head = next + 1;
+}
+
+bool eventsIsWatched(unsigned char pin) {
+    return pin >= 1 && pin <= SENSOR_DIGITAL_PINS && pins[pin].watched;
+}
+
+bool eventsWatch(unsigned char pin, unsigned long debounceUs) {
+    if (pin < 1 || pin > SENSOR_DIGITAL_PINS || pin == EVENT_NO_INTERRUPT_PIN)
+        return false;
+    PinState *state = &pins[pin];
+    state->level = digitalRead(pin);
+    state->debounce = debounceUs;
+    state->lastChange = micros();
+    state->rising = 0;
+    state->falling = 0;
+    state->watched = true;
+    ioSetInterrupt(pin, INTERRUPT_EDGE_BOTH, onEdge);
+    return true;
+}
+
+void eventsOnChange(unsigned char pin, EventCallback callback) {
+    if (pin >= 1 && pin <= SENSOR_DIGITAL_PINS)
+        pins[pin].callback = callback;
+}
+
+static void accept(unsigned char pin, bool level, unsigned long time) {
+    PinState *state = &pins[pin];
+    state->level = level;
+    state->lastChange = time;
+    if (level)
+        state->rising++;
+    else
+        state->falling++;
+    if (state->callback != NULL)
+        state->callback(pin, level, time);
+}
+
+void eventsDispatch() {
+    while (tail != head) {
+        __sync_synchronize();
+        Edge edge = queue[tail % EVENT_QUEUE_SIZE];
+        __sync_synchronize();
+        tail++;
+
+        if (!eventsIsWatched(edge.pin))
+            continue;
+        PinState *state = &pins[edge.pin];
+        // Edges that don't change the level, or that come too soon after the last change, are
+        // the switch bouncing
+        if (edge.level == state->level || edge.time - state->lastChange < state->debounce)
+            continue;
+        accept(edge.pin, edge.level, edge.time);
+    }
+
+    // Catch pins that settled somewhere else once the bouncing stopped
+    unsigned long now = micros();
+    for (unsigned char pin = 1; pin <= SENSOR_DIGITAL_PINS; pin++) {
+        PinState *state = &pins[pin];
+        if (!state->watched || now - state->lastChange < state->debounce)
+            continue;
+        bool level = digitalRead(pin);
+        if (level != state->level)
+            accept(pin, level, now);
+    }
+}
+
+bool eventsLevel(unsigned char pin) {
+    return eventsIsWatched(pin) ? pins[pin].level : false;
+}
+
+unsigned long eventsRisingCount(unsigned char pin) {
+    return eventsIsWatched(pin) ? pins[pin].rising : 0;
+}
+
+unsigned long eventsFallingCount(unsigned char pin) {
+    return eventsIsWatched(pin) ? pins[pin].falling : 0;
+}
+
+unsigned long eventsLastChange(unsigned char pin) {
+    return eventsIsWatched(pin) ? pins[pin].lastChange : 0;
+}
+
+unsigned long eventsDropped() {
+    return dropped;
+}
@@ -39,6 +39,29 @@ void initializeIO() {
  */
 
 void initialize() {
-    analogCalibrate(LEFT_POTENT);
-    analogCalibrate(RIGHT_POTENT);
+    lcdInit(LCD_PORT);
+    lcdClear(LCD_PORT);
+
+    // Sample all inputs in the background from now on, with the calibration offsets saved at an
+    // earlier boot if there are any
+    sensorsStart(SENSOR_PERIOD_MS);
+    // Holding the LCD's center button through boot measures the offsets again
+    if (lcdReadButtons(LCD_PORT) & LCD_BTN_CENTER)
+        sensorsCalibrate();
+    // Track the robot's pose from the drive IMEs and gyro from now on
+    odometryStart();
+    // Ramp and budget every motor write from now on
+    motorOutputStart();
+    // Timestamp every change of the limit switch as it happens
+    eventsWatch(LIMIT_SWITCH, EVENT_DEBOUNCE_US);
+    // Send telemetry over the debug stream whenever the control loop is idle
+    telemetryStart(stdout);
+    // Save the last seconds of every match to the file system once the robot is disabled
+    blackboxStart();
+    // Let the driver pick their joystick profile on the LCD before the match
+    inputShapeStart(LCD_PORT);
+    // Read the autonomous script now rather than on autonomous' first tick
+    autonomousPrepare();
+    // Run the control loop from now on, switching behaviors as the competition modes start
+    runtimeStart();
 }
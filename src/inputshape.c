@@ -0,0 +1,113 @@
+/** @file inputshape.c
+ * @brief Joystick input shaping
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Passes the axis straight through
+static const ShapeTable identity = SHAPE_TABLE(SHAPE_LINEAR, 0, 0);
+// No dead step past the deadband, unlike the old cutoff at 17
+static const ShapeTable linear = SHAPE_TABLE(SHAPE_LINEAR, 10, 0);
+// Half the throw gives about 35 power instead of 64
+static const ShapeTable cubic = SHAPE_TABLE(SHAPE_CUBIC, 8, 50);
+// Most of the throw for slow, careful moves
+static const ShapeTable quintic = SHAPE_TABLE(SHAPE_QUINTIC, 8, 70);
+
+// Drive curve for every main joystick axis, and the extender's curve for the partner's
+#define PROFILE(name, drive, extender) \
+    {name, {drive, drive, drive, drive, identity, extender, identity, identity}}
+
+const InputProfile inputProfiles[] = {
+    PROFILE("Standard", linear, linear),
+    PROFILE("Smooth", cubic, linear),
+    PROFILE("Precise", quintic, cubic),
+};
+const int inputProfileCount = sizeof(inputProfiles) / sizeof(inputProfiles[0]);
+
+static volatile int selected = 0;
+static PROS_FILE *lcd = NULL;
+static TaskHandle inputShapeTask = NULL;
+
+int inputShapeAxis(unsigned char joystick, unsigned char axis) {
+    int index = (joystick - 1) * 4 + axis - 1;
+    if (index < 0 || index >= INPUT_SHAPE_AXES)
+        return 0;
+    return inputProfiles[selected].axes[index][joyAnalog(joystick, axis) + 128];
+}
+
+void inputShapeSelect(int profile) {
+    if (profile >= 0 && profile < inputProfileCount)
+        selected = profile;
+}
+
+int inputShapeSelected() {
+    return selected;
+}
+
+static void load() {
+    PROS_FILE *stream = fopen(INPUT_SHAPE_FILE, "r");
+    if (stream == NULL)
+        return;
+    int profile = fgetc(stream);
+    fclose(stream);
+    inputShapeSelect(profile);
+}
+
+static void save() {
+    PROS_FILE *stream = fopen(INPUT_SHAPE_FILE, "w");
+    if (stream == NULL)
+        return;
+    fputc(selected, stream);
+    fclose(stream);
+}
+
+// Runs the LCD menu while the robot is disabled, when the LCD is free and files may be written
+static void inputShapeLoop(void *ignore) {
+    unsigned int lastButtons = 0;
+    int shown = -1;
+    bool shownMismatch = false;
+    while (1) {
+        if (isEnabled()) {
+            // Something else may use the LCD while enabled, so draw the menu again afterwards
+            shown = -1;
+        } else {
+            bool mismatch = sensorsCalibrationStatus() == SENSOR_CALIBRATION_MISMATCH;
+            unsigned int buttons = lcdReadButtons(lcd);
+            unsigned int pressed = buttons & ~lastButtons;
+            lastButtons = buttons;
+
+            int profile = selected;
+            if (pressed & LCD_BTN_LEFT)
+                profile = (profile + inputProfileCount - 1) % inputProfileCount;
+            if (pressed & LCD_BTN_RIGHT)
+                profile = (profile + 1) % inputProfileCount;
+            if (profile != selected) {
+                inputShapeSelect(profile);
+                save();
+            }
+            // The potentiometer offsets look wrong. Only the driver can tell whether the lift is
+            // at the bottom, so re-zeroing waits for them to say so.
+            if (mismatch && (pressed & LCD_BTN_CENTER))
+                sensorsRequestCalibration();
+            if (profile != shown || mismatch != shownMismatch) {
+                lcdSetText(lcd, 1, mismatch ? "Pots off? Ctr=0" : "Driver profile");
+                lcdPrint(lcd, 2, "< %-12s >", inputProfiles[profile].name);
+                shown = profile;
+                shownMismatch = mismatch;
+            }
+        }
+        delay(INPUT_SHAPE_LCD_MS);
+    }
+}
+
+void inputShapeStart(PROS_FILE *lcdPort) {
+    if (inputShapeTask != NULL)
+        return;
+    lcd = lcdPort;
+    load();
+    inputShapeTask = taskCreate(inputShapeLoop, TASK_DEFAULT_STACK_SIZE, NULL,
+        INPUT_SHAPE_TASK_PRIORITY);
+}
@@ -0,0 +1,220 @@
+/** @file joylog.c
+ * @brief Joystick input recorder and player
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Field of the first button group of each joystick, see joylog.h
+#define JOYLOG_DIGITAL_FIELD 8
+
+// This tick's state, and the last one written to the log
+static unsigned char state[JOYLOG_FIELDS];
+static unsigned char recorded[JOYLOG_FIELDS];
+
+static PROS_FILE *recordStream = NULL;
+// Ticks recorded as unchanged but not yet written
+static unsigned char pendingRun = 0;
+
+static PROS_FILE *replayStream = NULL;
+// Stays set once the log runs out, so the joysticks keep reading as released
+static bool replaying = false;
+// Ticks the replayed state stays the same for
+static unsigned char replayRun = 0;
+
+static bool isSerialPort(PROS_FILE *stream) {
+    return stream == uart1 || stream == uart2 || stream == stdout;
+}
+
+// Field and bit shift holding a joystick's button group
+static int digitalField(unsigned char joystick, unsigned char buttonGroup) {
+    return JOYLOG_DIGITAL_FIELD + (joystick - 1) * 2 + (buttonGroup - 5) / 2;
+}
+static int digitalShift(unsigned char buttonGroup) {
+    return ((buttonGroup - 5) & 1) * 4;
+}
+
+static void sampleJoysticks() {
+    for (int joystick = 1; joystick <= 2; joystick++) {
+        for (int axis = 1; axis <= 4; axis++)
+            state[(joystick - 1) * 4 + axis - 1] = (unsigned char)joystickGetAnalog(joystick, axis);
+        state[digitalField(joystick, 5)] = 0;
+        state[digitalField(joystick, 7)] = 0;
+        for (int group = 5; group <= 8; group++) {
+            int buttons = 0;
+            if (joystickGetDigital(joystick, group, JOY_DOWN))
+                buttons |= JOY_DOWN;
+            if (joystickGetDigital(joystick, group, JOY_LEFT))
+                buttons |= JOY_LEFT;
+            if (joystickGetDigital(joystick, group, JOY_UP))
+                buttons |= JOY_UP;
+            if (joystickGetDigital(joystick, group, JOY_RIGHT))
+                buttons |= JOY_RIGHT;
+            state[digitalField(joystick, group)] |= buttons << digitalShift(group);
+        }
+    }
+}
+
+static void releaseAll() {
+    for (int i = 0; i < JOYLOG_FIELDS; i++)
+        state[i] = 0;
+}
+
+static void endReplay() {
+    if (!isSerialPort(replayStream))
+        fclose(replayStream);
+    replayStream = NULL;
+    releaseAll();
+}
+
+// Reads the next tick of the log into state
+static void replayTick() {
+    if (replayRun > 0) {
+        replayRun--;
+        return;
+    }
+    int header = fgetc(replayStream);
+    if (header == EOF) {
+        endReplay();
+        return;
+    }
+    if (header & 0x80) {
+        // This tick is the first of the run
+        replayRun = (header & JOYLOG_MAX_RUN) - 1;
+        return;
+    }
+    // Anything but a mask, such as the header of the next log in a serial capture, ends this one
+    if (header > 0x0F) {
+        endReplay();
+        return;
+    }
+    int low = fgetc(replayStream);
+    if (low == EOF) {
+        endReplay();
+        return;
+    }
+    int mask = (header << 8) | low;
+    for (int i = 0; i < JOYLOG_FIELDS; i++) {
+        if (mask & (1 << i)) {
+            int value = fgetc(replayStream);
+            if (value == EOF) {
+                endReplay();
+                return;
+            }
+            state[i] = (unsigned char)value;
+        }
+    }
+}
+
+static void writeRun() {
+    if (pendingRun > 0) {
+        fputc(0x80 | pendingRun, recordStream);
+        pendingRun = 0;
+    }
+}
+
+static void recordTick() {
+    int mask = 0;
+    for (int i = 0; i < JOYLOG_FIELDS; i++) {
+        if (state[i] != recorded[i])
+            mask |= 1 << i;
+    }
+    if (mask == 0) {
+        if (++pendingRun == JOYLOG_MAX_RUN)
+            writeRun();
+        return;
+    }
+    writeRun();
+
+    // One write per tick, since each write to a serial port or file has a fixed cost
+    unsigned char record[2 + JOYLOG_FIELDS];
+    int length = 0;
+    record[length++] = (unsigned char)(mask >> 8);
+    record[length++] = (unsigned char)mask;
+    for (int i = 0; i < JOYLOG_FIELDS; i++) {
+        if (mask & (1 << i)) {
+            record[length++] = state[i];
+            recorded[i] = state[i];
+        }
+    }
+    fwrite(record, 1, length, recordStream);
+}
+
+void joylogUpdate() {
+    if (replayStream != NULL)
+        replayTick();
+    else if (!replaying)
+        sampleJoysticks();
+
+    if (recordStream != NULL)
+        recordTick();
+}
+
+int joyAnalog(unsigned char joystick, unsigned char axis) {
+    if (joystick < 1 || joystick > 2 || axis < 1 || axis > 4)
+        return 0;
+    return (signed char)state[(joystick - 1) * 4 + axis - 1];
+}
+
+bool joyDigital(unsigned char joystick, unsigned char buttonGroup, unsigned char button) {
+    if (joystick < 1 || joystick > 2 || buttonGroup < 5 || buttonGroup > 8)
+        return false;
+    int buttons = state[digitalField(joystick, buttonGroup)] >> digitalShift(buttonGroup);
+    return (buttons & button) != 0;
+}
+
+void joylogRecord(PROS_FILE *stream, unsigned char periodMs) {
+    if (recordStream != NULL)
+        joylogStop();
+    if (stream == NULL)
+        return;
+    // The log starts from released joysticks, the same as a replay does
+    for (int i = 0; i < JOYLOG_FIELDS; i++)
+        recorded[i] = 0;
+    pendingRun = 0;
+    unsigned char header[4] = {'J', 'L', JOYLOG_VERSION, periodMs};
+    fwrite(header, 1, sizeof(header), stream);
+    recordStream = stream;
+}
+
+bool joylogReplay(PROS_FILE *stream) {
+    if (replayStream != NULL)
+        endReplay();
+    if (stream == NULL)
+        return false;
+    replayStream = stream;
+    unsigned char header[4];
+    for (int i = 0; i < 4; i++)
+        header[i] = (unsigned char)fgetc(stream);
+    if (header[0] != 'J' || header[1] != 'L' || header[2] != JOYLOG_VERSION) {
+        endReplay();
+        replaying = false;
+        return false;
+    }
+    replaying = true;
+    replayRun = 0;
+    releaseAll();
+    return true;
+}
+
+void joylogStop() {
+    if (recordStream != NULL) {
+        writeRun();
+        if (!isSerialPort(recordStream))
+            fclose(recordStream);
+        recordStream = NULL;
+    }
+    if (replayStream != NULL)
+        endReplay();
+    replaying = false;
+}
+
+bool joylogIsRecording() {
+    return recordStream != NULL;
+}
+
+bool joylogIsReplaying() {
+    return replayStream != NULL;
+}
@@ -0,0 +1,127 @@
+/** @file lift.c
+ * @brief Upper lift control
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Sync gains on the Q16 left minus right difference. A 10% difference gives about 65.
+#define LIFT_SYNC_KP (PID_ONE / 100)
+#define LIFT_SYNC_KI (PID_ONE / 200)
+#define LIFT_SYNC_KD 0
+// Hold gains on the Q16 height error, a 10% drop adding about 33
+#define LIFT_HOLD_KP (PID_ONE / 200)
+#define LIFT_HOLD_KI (PID_ONE / 400)
+#define LIFT_HOLD_KD 0
+
+static Pid sync;
+static Pid hold;
+static bool holding = false;
+static int holdPosition = 0;
+
+// Power that just holds the lift's weight, which grows as the lift reaches out further
+static const int holdFeedforward[LIFT_HOLD_POINTS] = {10, 11, 12, 13, 14};
+
+// One cone higher each, starting with the first cone on an empty goal
+const int liftStackHeights[LIFT_STACK_HEIGHTS] = {
+    POTENT_ONE * 12 / 100,
+    POTENT_ONE * 30 / 100,
+    POTENT_ONE * 48 / 100,
+    POTENT_ONE * 66 / 100,
+    POTENT_ONE * 84 / 100,
+};
+
+void liftInit() {
+    pidInit(&sync, LIFT_SYNC_KP, LIFT_SYNC_KI, LIFT_SYNC_KD, SCHED_PERIOD_MS);
+    pidInit(&hold, LIFT_HOLD_KP, LIFT_HOLD_KI, LIFT_HOLD_KD, SCHED_PERIOD_MS);
+    pidSetOutputLimit(&hold, LIFT_HOLD_LIMIT);
+    holding = false;
+}
+
+static void drive(int speed) {
+    if (speed == 0) {
+        // Nothing moving, so don't let the integral build up while stopped
+        pidReset(&sync);
+        motorFrameSetGroup(MOTOR_GROUP_UPPER_LIFT, 0);
+        return;
+    }
+
+    // Positive when the right side is higher and the left needs to catch up
+    int correction = pidUpdate(&sync, 0, getLeftPotentQ16() - getRightPotentQ16());
+    int lSpeed = speed + correction;
+    int rSpeed = speed - correction;
+
+    // Shift both sides back into range so the difference between them is kept
+    int high = lSpeed > rSpeed ? lSpeed : rSpeed;
+    int low = lSpeed < rSpeed ? lSpeed : rSpeed;
+    if (high > MOTOR_MAX_SPEED) {
+        lSpeed -= high - MOTOR_MAX_SPEED;
+        rSpeed -= high - MOTOR_MAX_SPEED;
+    } else if (low < -MOTOR_MAX_SPEED) {
+        lSpeed -= low + MOTOR_MAX_SPEED;
+        rSpeed -= low + MOTOR_MAX_SPEED;
+    }
+
+    motorFrameSet(UPPER_LIFT_L, lSpeed);
+    motorFrameSet(UPPER_LIFT_R, rSpeed);
+}
+
+void liftDrive(int speed) {
+    holding = false;
+    drive(speed);
+}
+
+// Feedforward at a height, interpolated between the table's points
+static int feedforward(int position) {
+    if (position <= 0)
+        return holdFeedforward[0];
+    if (position >= POTENT_ONE)
+        return holdFeedforward[LIFT_HOLD_POINTS - 1];
+    int scaled = position * (LIFT_HOLD_POINTS - 1);
+    int index = scaled / POTENT_ONE;
+    int within = scaled % POTENT_ONE;
+    return holdFeedforward[index] +
+        (holdFeedforward[index + 1] - holdFeedforward[index]) * within / POTENT_ONE;
+}
+
+void liftHold() {
+    int position = liftPosition();
+    if (!holding) {
+        holding = true;
+        holdPosition = position;
+        pidReset(&hold);
+    }
+    if (holdPosition < LIFT_HOLD_FLOOR) {
+        drive(0);
+        return;
+    }
+
+    int speed = feedforward(holdPosition) + pidUpdate(&hold, holdPosition, position);
+    if (speed > LIFT_HOLD_LIMIT)
+        speed = LIFT_HOLD_LIMIT;
+    else if (speed < -LIFT_HOLD_LIMIT)
+        speed = -LIFT_HOLD_LIMIT;
+    drive(speed);
+}
+
+int liftPosition() {
+    return (getLeftPotentQ16() + getRightPotentQ16()) / 2;
+}
+
+int liftStackAbove(int position) {
+    for (int i = 0; i < LIFT_STACK_HEIGHTS; i++) {
+        if (liftStackHeights[i] > position + LIFT_PRESET_MARGIN)
+            return liftStackHeights[i];
+    }
+    return liftStackHeights[LIFT_STACK_HEIGHTS - 1];
+}
+
+int liftStackBelow(int position) {
+    for (int i = LIFT_STACK_HEIGHTS - 1; i >= 0; i--) {
+        if (liftStackHeights[i] < position - LIFT_PRESET_MARGIN)
+            return liftStackHeights[i];
+    }
+    return liftStackHeights[0];
+}
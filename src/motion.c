@@ -0,0 +1,249 @@
+/** @file motion.c
+ * @brief Non-blocking autonomous motion primitives
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Ticks a primitive has to stay within tolerance before it counts as done
+#define MOTION_SETTLE_TICKS 5
+
+#define DRIVE_TOLERANCE 20
+// Drive speeds in IME ticks per second. Moves at full speed cruise a little under the free speed
+// of a 393 in high torque mode, so the controller has some power left to catch up with.
+#define DRIVE_FREE_SPEED 1050
+#define DRIVE_MAX_VELOCITY 1000
+#define DRIVE_ACCELERATION 4000
+#define DRIVE_KP (PID_ONE * 2 / 5)
+#define DRIVE_KI 0
+#define DRIVE_KD (PID_ONE / 50)
+// Heading correction while driving straight, per degree off
+#define HEADING_KP (PID_ONE * 4)
+
+#define TURN_TOLERANCE 2
+#define TURN_KP (PID_ONE * 4)
+#define TURN_KI (PID_ONE / 2)
+#define TURN_KD (PID_ONE / 10)
+
+#define LIFT_TOLERANCE (POTENT_ONE / 50)
+// Lift speeds in Q16 positions per second
+#define LIFT_FREE_SPEED (POTENT_ONE * 7 / 10)
+#define LIFT_MAX_VELOCITY (POTENT_ONE * 6 / 10)
+#define LIFT_ACCELERATION (POTENT_ONE * 3)
+#define LIFT_KP (PID_ONE / 100)
+#define LIFT_KI (PID_ONE / 400)
+#define LIFT_KD 0
+
+// The lower lift has no sensor, so its profile is of motor power, ramping by this much per second
+#define LOWER_LIFT_ACCELERATION 800
+
+typedef enum {
+    PRIMITIVE_DRIVE,
+    PRIMITIVE_TURN,
+    PRIMITIVE_LIFT,
+    PRIMITIVE_TIMED,
+} PrimitiveType;
+
+typedef struct {
+    MotionState state;
+    PrimitiveType type;
+    int target;
+    // Sensor readings when the primitive started
+    int startDistance;
+    int startHeading;
+    int startPosition;
+    unsigned long startTime;
+    unsigned long timeout;
+    int settledTicks;
+    Pid pid;
+    // Setpoints for profiled primitives, from startTime on
+    MotionProfile profile;
+} Motion;
+
+static Motion motions[MOTION_CHANNELS];
+static Pid heading;
+
+static void stopChannel(MotionChannel channel) {
+    switch (channel) {
+    case MOTION_DRIVE:
+        motorFrameSetGroup(MOTOR_GROUP_DRIVE, 0);
+        break;
+    case MOTION_UPPER_LIFT:
+        liftDrive(0);
+        break;
+    case MOTION_LOWER_LIFT:
+        motorFrameSetGroup(MOTOR_GROUP_LOWER_LIFT, 0);
+        break;
+    default:
+        break;
+    }
+}
+
+static int driveDistance(const SensorFrame *sensors) {
+    return (sensors->ime[L_DRIVE_IME] + sensors->ime[R_DRIVE_IME]) / 2;
+}
+
+static Motion *start(MotionChannel channel, PrimitiveType type, int target,
+        unsigned long timeoutMs) {
+    Motion *motion = &motions[channel];
+    SensorFrame sensors;
+    sensorsGet(&sensors);
+
+    motion->state = MOTION_RUNNING;
+    motion->type = type;
+    motion->target = target;
+    motion->startDistance = driveDistance(&sensors);
+    motion->startHeading = sensors.gyro;
+    motion->startPosition = liftPosition();
+    motionProfileInit(&motion->profile, MOTION_PROFILE_TRAPEZOID, 0, 0, 0);
+    motion->startTime = millis();
+    motion->timeout = timeoutMs;
+    motion->settledTicks = 0;
+    return motion;
+}
+
+void motionInit() {
+    for (int channel = 0; channel < MOTION_CHANNELS; channel++) {
+        motions[channel].state = MOTION_IDLE;
+        stopChannel(channel);
+    }
+    pidInit(&heading, HEADING_KP, 0, 0, SCHED_PERIOD_MS);
+}
+
+void motionDriveDistance(int ticks, int maxSpeed, unsigned long timeoutMs) {
+    Motion *motion = start(MOTION_DRIVE, PRIMITIVE_DRIVE, ticks, timeoutMs);
+    pidInit(&motion->pid, DRIVE_KP, DRIVE_KI, DRIVE_KD, SCHED_PERIOD_MS);
+    motionProfileInit(&motion->profile, MOTION_PROFILE_S_CURVE, ticks,
+        (long)DRIVE_MAX_VELOCITY * abs(maxSpeed) / MOTOR_MAX_SPEED, DRIVE_ACCELERATION);
+    pidReset(&heading);
+}
+
+void motionTurnTo(int target, unsigned long timeoutMs) {
+    Motion *motion = start(MOTION_DRIVE, PRIMITIVE_TURN, target, timeoutMs);
+    pidInit(&motion->pid, TURN_KP, TURN_KI, TURN_KD, SCHED_PERIOD_MS);
+}
+
+void motionLiftTo(int position, unsigned long timeoutMs) {
+    Motion *motion = start(MOTION_UPPER_LIFT, PRIMITIVE_LIFT, position, timeoutMs);
+    pidInit(&motion->pid, LIFT_KP, LIFT_KI, LIFT_KD, SCHED_PERIOD_MS);
+    motionProfileInit(&motion->profile, MOTION_PROFILE_S_CURVE,
+        position - motion->startPosition, LIFT_MAX_VELOCITY, LIFT_ACCELERATION);
+}
+
+void motionLowerLiftFor(int speed, unsigned long durationMs) {
+    Motion *motion = start(MOTION_LOWER_LIFT, PRIMITIVE_TIMED, 0, durationMs);
+    // Ramps the power up and down and runs a little longer, to move about as far as running at
+    // the speed for the whole time would. Powers are scaled up by 1000 so the profile's
+    // distance, in power milliseconds, keeps its precision.
+    motionProfileInit(&motion->profile, MOTION_PROFILE_S_CURVE, (long)speed * (long)durationMs,
+        abs(speed) * 1000L, LOWER_LIFT_ACCELERATION * 1000L);
+    motion->timeout = motionProfileDuration(&motion->profile);
+}
+
+void motionStop(MotionChannel channel) {
+    if (motions[channel].state == MOTION_RUNNING)
+        motions[channel].state = MOTION_TIMEOUT;
+    stopChannel(channel);
+}
+
+MotionState motionGetState(MotionChannel channel) {
+    return motions[channel].state;
+}
+
+bool motionIsBusy(MotionChannel channel) {
+    return motions[channel].state == MOTION_RUNNING;
+}
+
+// Runs one tick of a primitive and returns its remaining error
+static int step(Motion *motion, const SensorFrame *sensors, unsigned long now) {
+    MotionSetpoint setpoint;
+    motionProfileAt(&motion->profile, now - motion->startTime, &setpoint);
+    int error;
+    switch (motion->type) {
+    case PRIMITIVE_DRIVE: {
+        int travelled = driveDistance(sensors) - motion->startDistance;
+        // Feeds the profile's velocity forward and corrects for falling behind or ahead of it
+        int speed = setpoint.velocity * MOTOR_MAX_SPEED / DRIVE_FREE_SPEED +
+            pidUpdate(&motion->pid, setpoint.position, travelled);
+        // Positive when the robot has drifted clockwise and has to steer back left
+        int correction = pidUpdate(&heading, motion->startHeading, sensors->gyro);
+        motorFrameSet(L_DRIVE, speed - correction);
+        motorFrameSet(R_DRIVE, speed + correction);
+        error = motion->target - travelled;
+        break;
+    }
+    case PRIMITIVE_TURN: {
+        if (!sensors->gyroValid) {
+            // Reads 0 until the gyro starts after a reset, so wait for it or the timeout
+            motorFrameSetGroup(MOTOR_GROUP_DRIVE, 0);
+            error = TURN_TOLERANCE + 1;
+            break;
+        }
+        int turn = pidUpdate(&motion->pid, motion->target, sensors->gyro);
+        // Positive turns counterclockwise
+        motorFrameSet(L_DRIVE, -turn);
+        motorFrameSet(R_DRIVE, turn);
+        error = motion->target - sensors->gyro;
+        break;
+    }
+    case PRIMITIVE_LIFT: {
+        int position = liftPosition();
+        liftDrive(setpoint.velocity * MOTOR_MAX_SPEED / LIFT_FREE_SPEED +
+            pidUpdate(&motion->pid, motion->startPosition + setpoint.position, position));
+        error = motion->target - position;
+        break;
+    }
+    default:
+        motorFrameSetGroup(MOTOR_GROUP_LOWER_LIFT, setpoint.velocity / 1000);
+        // Timed primitives only finish by running out of time
+        error = 1;
+        break;
+    }
+    return abs(error);
+}
+
+static int tolerance(PrimitiveType type) {
+    switch (type) {
+    case PRIMITIVE_DRIVE:
+        return DRIVE_TOLERANCE;
+    case PRIMITIVE_TURN:
+        return TURN_TOLERANCE;
+    case PRIMITIVE_LIFT:
+        return LIFT_TOLERANCE;
+    default:
+        return 0;
+    }
+}
+
+void motionUpdate() {
+    SensorFrame sensors;
+    sensorsGet(&sensors);
+    unsigned long now = millis();
+
+    for (int channel = 0; channel < MOTION_CHANNELS; channel++) {
+        Motion *motion = &motions[channel];
+        if (motion->state != MOTION_RUNNING)
+            continue;
+
+        if (now - motion->startTime >= motion->timeout) {
+            // Running out of time is how timed primitives finish
+            motion->state = motion->type == PRIMITIVE_TIMED ? MOTION_DONE : MOTION_TIMEOUT;
+            if (motion->state == MOTION_TIMEOUT)
+                blackboxFault(BLACKBOX_REASON_TIMEOUT);
+            stopChannel(channel);
+            continue;
+        }
+
+        if (step(motion, &sensors, now) <= tolerance(motion->type))
+            motion->settledTicks++;
+        else
+            motion->settledTicks = 0;
+
+        if (motion->settledTicks >= MOTION_SETTLE_TICKS) {
+            motion->state = MOTION_DONE;
+            stopChannel(channel);
+        }
+    }
+}
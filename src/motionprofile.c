@@ -0,0 +1,150 @@
+/** @file motionprofile.c
+ * @brief Motion profile generator
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Fractions of a ramp are Q16
+#define ONE 65536
+// The S-curve tables have an entry every 1 / 2^STEP_BITS of a ramp
+#define STEP_BITS 5
+#define STEPS (1 << STEP_BITS)
+#define STEP_SHIFT (16 - STEP_BITS)
+
+// Velocity through an S-curve ramp as a fraction of the peak, 3u^2 - 2u^3
+static const int sCurveVelocity[STEPS + 1] = {
+    0, 188, 736, 1620, 2816, 4300, 6048, 8036, 10240, 12636, 15200, 17908, 20736, 23660, 26656,
+    29700, 32768, 35836, 38880, 41876, 44800, 47628, 50336, 52900, 55296, 57500, 59488, 61236,
+    62720, 63916, 64800, 65348, 65536,
+};
+
+// Distance through an S-curve ramp as a fraction of the peak velocity times the ramp's length,
+// u^3 - u^4 / 2, ending at half like a linear ramp does
+static const int sCurvePosition[STEPS + 1] = {
+    0, 2, 16, 51, 120, 230, 392, 611, 896, 1253, 1688, 2204, 2808, 3501, 4288, 5168, 6144, 7216,
+    8384, 9645, 11000, 12444, 13976, 15589, 17280, 19043, 20872, 22758, 24696, 26675, 28688,
+    30722, 32768,
+};
+
+static int lookup(const int *table, long fraction) {
+    long index = fraction >> STEP_SHIFT;
+    if (index >= STEPS)
+        return table[STEPS];
+    int within = fraction & ((1 << STEP_SHIFT) - 1);
+    return table[index] + (((table[index + 1] - table[index]) * within) >> STEP_SHIFT);
+}
+
+static unsigned long long squareRoot(unsigned long long value) {
+    unsigned long long root = 0;
+    unsigned long long bit = 1ULL << 62;
+    while (bit > value)
+        bit >>= 2;
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// Milliseconds to ramp up to a velocity. S-curves peak at 1.5 times their average acceleration.
+static unsigned long rampTime(MotionProfileShape shape, long velocity, long acceleration) {
+    long long ms = (long long)velocity * 1000 / acceleration;
+    return shape == MOTION_PROFILE_S_CURVE ? ms * 3 / 2 : ms;
+}
+
+void motionProfileInit(MotionProfile *profile, MotionProfileShape shape, long distance,
+        long maxVelocity, long acceleration) {
+    profile->shape = shape;
+    profile->distance = distance;
+    profile->velocity = 0;
+    profile->rampMs = 0;
+    profile->cruiseMs = 0;
+
+    long length = labs(distance);
+    if (length == 0 || maxVelocity <= 0 || acceleration <= 0)
+        return;
+
+    long velocity = maxVelocity;
+    unsigned long rampMs = rampTime(shape, velocity, acceleration);
+    // Both ramps together cover the peak velocity times one ramp's length
+    long long rampsLength = (long long)velocity * rampMs / 1000;
+    if (rampsLength >= length) {
+        // Too short to reach the cruising speed. The ramps cover the whole distance when
+        // velocity^2 = length * acceleration, or two thirds of that for S-curves.
+        unsigned long long square = (unsigned long long)length * acceleration;
+        if (shape == MOTION_PROFILE_S_CURVE)
+            square = square * 2 / 3;
+        velocity = squareRoot(square);
+        if (velocity < 1)
+            velocity = 1;
+        rampMs = rampTime(shape, velocity, acceleration);
+        profile->cruiseMs = 0;
+    } else {
+        profile->cruiseMs = (length - rampsLength) * 1000 / velocity;
+    }
+    profile->velocity = velocity;
+    profile->rampMs = rampMs;
+}
+
+unsigned long motionProfileDuration(const MotionProfile *profile) {
+    return 2 * profile->rampMs + profile->cruiseMs;
+}
+
+// Distance and velocity a given time into the ramp up
+static void ramp(const MotionProfile *profile, unsigned long ms, long *position, long *velocity) {
+    long fraction = (long long)ms * ONE / profile->rampMs;
+    int moved;
+    int speed;
+    if (profile->shape == MOTION_PROFILE_S_CURVE) {
+        moved = lookup(sCurvePosition, fraction);
+        speed = lookup(sCurveVelocity, fraction);
+    } else {
+        moved = ((long long)fraction * fraction) >> 17;
+        speed = fraction;
+    }
+    *position = (long long)profile->velocity * profile->rampMs * moved / (1000LL * ONE);
+    *velocity = ((long long)profile->velocity * speed) >> 16;
+}
+
+bool motionProfileAt(const MotionProfile *profile, unsigned long elapsedMs,
+        MotionSetpoint *setpoint) {
+    long length = labs(profile->distance);
+    unsigned long rampMs = profile->rampMs;
+    unsigned long total = motionProfileDuration(profile);
+    long position;
+    long velocity;
+    bool done = false;
+
+    if (elapsedMs >= total) {
+        position = length;
+        velocity = 0;
+        done = true;
+    } else if (elapsedMs < rampMs) {
+        ramp(profile, elapsedMs, &position, &velocity);
+    } else if (elapsedMs < rampMs + profile->cruiseMs) {
+        position = (long long)profile->velocity * rampMs / 2000 +
+            (long long)profile->velocity * (elapsedMs - rampMs) / 1000;
+        velocity = profile->velocity;
+    } else {
+        // The ramp down mirrors the ramp up, measured back from the end so it stops exactly there
+        long remaining;
+        ramp(profile, total - elapsedMs, &remaining, &velocity);
+        position = length - remaining;
+    }
+
+    if (profile->distance < 0) {
+        position = -position;
+        velocity = -velocity;
+    }
+    setpoint->position = position;
+    setpoint->velocity = velocity;
+    return done;
+}
@@ -0,0 +1,197 @@
+/** @file motors.c
+ * @brief Per-tick motor command frame and output stage
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+const MotorConfig motorConfigs[MOTOR_PORTS + 1] = {
+    //               port          reversed  maxSpeed  slew           group
+    [R_DRIVE] =      {R_DRIVE,      false,    127,      16,            MOTOR_GROUP_DRIVE},
+    [L_DRIVE] =      {L_DRIVE,      false,    127,      16,            MOTOR_GROUP_DRIVE},
+    [LOWER_LIFT_L] = {LOWER_LIFT_L, false,    127,      10,            MOTOR_GROUP_LOWER_LIFT},
+    [LOWER_LIFT_R] = {LOWER_LIFT_R, true,     127,      10,            MOTOR_GROUP_LOWER_LIFT},
+    [UPPER_LIFT_L] = {UPPER_LIFT_L, false,    127,      12,            MOTOR_GROUP_UPPER_LIFT},
+    [UPPER_LIFT_R] = {UPPER_LIFT_R, false,    127,      12,            MOTOR_GROUP_UPPER_LIFT},
+    [UPPER_EXT_L] =  {UPPER_EXT_L,  false,    127,      20,            MOTOR_GROUP_EXTENDER},
+    [UPPER_EXT_R] =  {UPPER_EXT_R,  false,    127,      20,            MOTOR_GROUP_EXTENDER},
+    [CLAW] =         {CLAW,         false,    67,       MOTOR_NO_SLEW, MOTOR_GROUP_CLAW},
+};
+
+// Pushing matches are won by the drive, and a lift carrying cones shouldn't drop them
+const MotorGroup motorGroupPriority[MOTOR_GROUPS - 1] = {
+    MOTOR_GROUP_DRIVE,
+    MOTOR_GROUP_UPPER_LIFT,
+    MOTOR_GROUP_LOWER_LIFT,
+    MOTOR_GROUP_CLAW,
+    MOTOR_GROUP_EXTENDER,
+};
+
+// Requested speeds, indexed by port
+static int commands[MOTOR_PORTS + 1];
+
+// Flushed frames, clamped to each motor's maxSpeed. The newest is in targets[published & 1].
+static int targets[2][MOTOR_PORTS + 1];
+static volatile unsigned long published = 0;
+// Bumped by motorFrameInit() to make the output stage write every port again
+static volatile unsigned long resets = 0;
+
+// Owned by the output task: the output of each port before reversal, and whether the motors
+// have been written since the last reset
+static int outputs[MOTOR_PORTS + 1];
+static bool written = false;
+static unsigned long seenResets = 0;
+static TaskHandle outputTask = NULL;
+
+void motorFrameInit() {
+    for (int port = 1; port <= MOTOR_PORTS; port++)
+        commands[port] = 0;
+    motorFrameFlush();
+    resets++;
+}
+
+void motorFrameSet(unsigned char port, int speed) {
+    if (port < 1 || port > MOTOR_PORTS)
+        return;
+    commands[port] = speed;
+}
+
+void motorFrameSetGroup(MotorGroup group, int speed) {
+    for (int port = 1; port <= MOTOR_PORTS; port++) {
+        if (motorConfigs[port].group == group)
+            commands[port] = speed;
+    }
+}
+
+int motorFrameGet(unsigned char port) {
+    if (port < 1 || port > MOTOR_PORTS)
+        return 0;
+    return commands[port];
+}
+
+void motorFrameFlush() {
+    unsigned long next = published + 1;
+    int *frame = targets[next & 1];
+    for (int port = 1; port <= MOTOR_PORTS; port++) {
+        int maxSpeed = motorConfigs[port].maxSpeed;
+        int target = commands[port];
+        if (target > maxSpeed)
+            target = maxSpeed;
+        else if (target < -maxSpeed)
+            target = -maxSpeed;
+        frame[port] = target;
+    }
+    // The frame has to be complete in memory before the output task can pick it
+    __sync_synchronize();
+    published = next;
+}
+
+int motorOutputGet(unsigned char port) {
+    if (port < 1 || port > MOTOR_PORTS)
+        return 0;
+    return outputs[port];
+}
+
+// Copies the newest flushed frame, the same way sensorsGet() does
+static void readTargets(int *frame) {
+    unsigned long sequence;
+    do {
+        sequence = published;
+        __sync_synchronize();
+        for (int port = 1; port <= MOTOR_PORTS; port++)
+            frame[port] = targets[sequence & 1][port];
+        __sync_synchronize();
+    } while (sequence != published);
+}
+
+static int slewToward(int output, int target, int slew) {
+    if (slew == MOTOR_NO_SLEW)
+        return target;
+    // Reversing starts again from a stop
+    if ((output > 0 && target < 0) || (output < 0 && target > 0))
+        output = 0;
+    if (target > output + slew && target > 0)
+        return output + slew;
+    if (target < output - slew && target < 0)
+        return output - slew;
+    return target;
+}
+
+// Scales the outputs down, group by group, until they fit the budget for this battery level
+static void applyBudget(int *frame) {
+    long budget = MOTOR_POWER_BUDGET;
+    unsigned int battery = powerLevelMain();
+    if (battery > 0)
+        budget = budget * MOTOR_NOMINAL_MV / battery;
+
+    for (int i = 0; i < MOTOR_GROUPS - 1; i++) {
+        MotorGroup group = motorGroupPriority[i];
+        long demand = 0;
+        for (int port = 1; port <= MOTOR_PORTS; port++) {
+            if (motorConfigs[port].group == group)
+                demand += abs(frame[port]);
+        }
+        if (demand <= budget) {
+            budget -= demand;
+            continue;
+        }
+        for (int port = 1; port <= MOTOR_PORTS; port++) {
+            if (motorConfigs[port].group == group)
+                frame[port] = frame[port] * budget / demand;
+        }
+        budget = 0;
+    }
+}
+
+static void outputStep() {
+    int frame[MOTOR_PORTS + 1];
+    readTargets(frame);
+
+    unsigned long reset = resets;
+    if (reset != seenResets) {
+        seenResets = reset;
+        written = false;
+    }
+
+    // The kernel stops the motors while disabled, so start from a stop when enabled again
+    bool enabled = isEnabled();
+    for (int port = 1; port <= MOTOR_PORTS; port++) {
+        if (!enabled)
+            outputs[port] = 0;
+        else if (motorConfigs[port].port == 0)
+            frame[port] = 0;
+        else
+            frame[port] = slewToward(outputs[port], frame[port], motorConfigs[port].slew);
+    }
+    if (!enabled) {
+        written = false;
+        return;
+    }
+    applyBudget(frame);
+
+    for (int port = 1; port <= MOTOR_PORTS; port++) {
+        const MotorConfig *config = &motorConfigs[port];
+        if (config->port == 0)
+            continue;
+        if (!written || frame[port] != outputs[port])
+            motorSet(port, config->reversed ? -frame[port] : frame[port]);
+        outputs[port] = frame[port];
+    }
+    written = true;
+}
+
+static void outputLoop(void *ignore) {
+    unsigned long wakeTime = millis();
+    while (1) {
+        outputStep();
+        taskDelayUntil(&wakeTime, MOTOR_OUTPUT_PERIOD_MS);
+    }
+}
+
+void motorOutputStart() {
+    if (outputTask != NULL)
+        return;
+    outputTask = taskCreate(outputLoop, TASK_DEFAULT_STACK_SIZE, NULL, MOTOR_OUTPUT_PRIORITY);
+}
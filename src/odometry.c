@@ -0,0 +1,189 @@
+/** @file odometry.c
+ * @brief Odometry task
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Headings are kept with 8 more bits than published, so small turns add up
+#define HEADING_SHIFT 8
+#define TURN (ODOMETRY_TURN << HEADING_SHIFT)
+// Change of the heading per tick of difference between the sides, using 710 / 113 for 2 pi
+#define TURN_PER_TICK ((TURN * 113) / (710L * ODOMETRY_TRACK_WIDTH))
+// Sines have 14 fraction bits
+#define SINE_SHIFT 14
+
+// Sine of each 64th of a quarter turn
+static const short sineTable[65] = {
+    0, 402, 804, 1205, 1606, 2006, 2404, 2801, 3196, 3590, 3981, 4370, 4756, 5139, 5520, 5897,
+    6270, 6639, 7005, 7366, 7723, 8076, 8423, 8765, 9102, 9434, 9760, 10080, 10394, 10702,
+    11003, 11297, 11585, 11866, 12140, 12406, 12665, 12916, 13160, 13395, 13623, 13842, 14053,
+    14256, 14449, 14635, 14811, 14978, 15137, 15286, 15426, 15557, 15679, 15791, 15893, 15986,
+    16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379, 16384,
+};
+
+static Pose buffers[2];
+// Poses published so far. The newest pose is in buffers[published & 1].
+static volatile unsigned long published = 0;
+static TaskHandle odometryTask = NULL;
+static int section = PROFILE_NONE;
+
+// Only the task touches these
+static long x = 0;
+static long y = 0;
+static long heading = 0;
+static int lastIme[SENSOR_IMES];
+static int lastGyro = 0;
+static long gyroHeading = 0;
+// The gyro starts in the background, some time after the odometry task
+static bool gyroStarted = false;
+// Added to the gyro's heading, so the gyro agrees with a heading given to odometrySet()
+static long gyroOffset = 0;
+
+// Written by odometrySet() and picked up by the task's next pass
+static volatile bool setPending = false;
+static long setX;
+static long setY;
+static long setHeading;
+
+// Sine of a heading in ODOMETRY_TURN units, interpolated between table entries
+static int sine(long angle) {
+    unsigned int turn = (unsigned long)angle & (ODOMETRY_TURN - 1);
+    unsigned int quadrant = turn >> 14;
+    unsigned int within = turn & 0x3FFF;
+    if (quadrant & 1)
+        within = 0x4000 - within;
+    unsigned int index = within >> 8;
+    int value = sineTable[index];
+    if (index < 64)
+        value += ((sineTable[index + 1] - value) * (int)(within & 0xFF)) >> 8;
+    return quadrant & 2 ? -value : value;
+}
+
+static int cosine(long angle) {
+    return sine(angle + ODOMETRY_TURN / 4);
+}
+
+static long headingOfGyro(int degrees) {
+    return (long)((long long)degrees * TURN / 360);
+}
+
+static void publish(unsigned long time) {
+    unsigned long next = published + 1;
+    Pose *pose = &buffers[next & 1];
+    pose->sequence = next;
+    pose->time = time;
+    pose->x = x;
+    pose->y = y;
+    pose->heading = heading >> HEADING_SHIFT;
+    // The pose has to be complete in memory before readers can pick it
+    __sync_synchronize();
+    published = next;
+}
+
+static void update() {
+    SensorFrame frame;
+    sensorsGet(&frame);
+
+    if (setPending) {
+        x = setX;
+        y = setY;
+        heading = setHeading << HEADING_SHIFT;
+        gyroOffset = heading - gyroHeading;
+        setPending = false;
+    }
+
+    int left = 0;
+    int right = 0;
+    // A missed IME read counts towards the next pass instead
+    if ((frame.imeValid & (1 << L_DRIVE_IME)) && (frame.imeValid & (1 << R_DRIVE_IME))) {
+        left = frame.ime[L_DRIVE_IME] - lastIme[L_DRIVE_IME];
+        right = frame.ime[R_DRIVE_IME] - lastIme[R_DRIVE_IME];
+        lastIme[L_DRIVE_IME] = frame.ime[L_DRIVE_IME];
+        lastIme[R_DRIVE_IME] = frame.ime[R_DRIVE_IME];
+        if (left > ODOMETRY_MAX_STEP || left < -ODOMETRY_MAX_STEP ||
+            right > ODOMETRY_MAX_STEP || right < -ODOMETRY_MAX_STEP)
+            left = right = 0;
+    }
+
+    long turn = (long)(right - left) * TURN_PER_TICK;
+    long middle = (heading + turn / 2) >> HEADING_SHIFT;
+    heading += turn;
+
+    if (frame.gyroValid && !gyroStarted) {
+        // The gyro counts from its start, so it agrees with the IMEs from there on
+        lastGyro = frame.gyro;
+        gyroHeading = headingOfGyro(frame.gyro);
+        gyroOffset = heading - gyroHeading;
+        gyroStarted = true;
+    }
+    if (gyroStarted) {
+        // Converting the gyro takes a long division, so only when it moves
+        if (frame.gyro != lastGyro) {
+            lastGyro = frame.gyro;
+            gyroHeading = headingOfGyro(frame.gyro);
+        }
+        heading += (gyroHeading + gyroOffset - heading) >> ODOMETRY_GYRO_SHIFT;
+    }
+
+    // Distance along the middle heading, with ODOMETRY_SHIFT fraction bits
+    long forward = (long)(left + right) << (ODOMETRY_SHIFT - 1);
+    x += (forward * cosine(middle)) >> SINE_SHIFT;
+    y += (forward * sine(middle)) >> SINE_SHIFT;
+
+    publish(frame.time / 1000);
+}
+
+static void odometryLoop(void *ignore) {
+    unsigned long wakeTime = millis();
+    while (1) {
+        if (profilerIsEnabled()) {
+            unsigned long start = profilerClock();
+            update();
+            profilerRecord(section, profilerClock() - start);
+        } else {
+            update();
+        }
+        taskDelayUntil(&wakeTime, ODOMETRY_PERIOD_MS);
+    }
+}
+
+void odometryStart() {
+    if (odometryTask != NULL)
+        return;
+    // Counts from here on, wherever the IMEs and gyro are now
+    SensorFrame frame;
+    sensorsGet(&frame);
+    for (int address = 0; address < SENSOR_IMES; address++)
+        lastIme[address] = frame.ime[address];
+    gyroStarted = frame.gyroValid;
+    lastGyro = frame.gyro;
+    gyroHeading = headingOfGyro(frame.gyro);
+    gyroOffset = -gyroHeading;
+    publish(millis());
+
+    section = profilerSection("odometry");
+    odometryTask = taskCreate(odometryLoop, TASK_DEFAULT_STACK_SIZE, NULL,
+        ODOMETRY_TASK_PRIORITY);
+}
+
+void odometryGet(Pose *pose) {
+    unsigned long sequence;
+    do {
+        sequence = published;
+        __sync_synchronize();
+        *pose = buffers[sequence & 1];
+        __sync_synchronize();
+        // Once another pose is published, the task starts refilling the buffer just copied
+    } while (sequence != published);
+}
+
+void odometrySet(long newX, long newY, long newHeading) {
+    setX = newX;
+    setY = newY;
+    setHeading = newHeading;
+    __sync_synchronize();
+    setPending = true;
+}
@@ -34,18 +34,28 @@
   * Controller setups:
   *
   * Main controller:
-  *	Right joystick = 1 stick drive
+  *	Joysticks = Drive, in driveMode
+  *		Tank = Left stick runs the left side, right stick the right side
+  *		Arcade or curvature = Right stick, up and down to drive, left and right to turn
+  *	Left buttons (7) = Drive at full power, up and down to drive, left and right to turn
   *  Back right buttons (6) = Lower lift
   *		Upper button = Raise
   *		Lower button = Lower
   *
   * Partner controller:
-  * 	Back right buttons (6) = Upper lift
+  *	Left buttons (7) = Upper lift, cancelling any preset
   *		Upper button = Raise
   *		Lower button = Lower
-  *	Back left buttons (5) = Claw
-  *		Upper button = Close claw
-  *		Lower button = Open claw
+  *	Back left buttons (5) = Upper lift presets
+  *		Upper button = Loader height
+  *		Lower button = Bottom
+  *	Back right buttons (6) = Upper lift stacking heights
+  *		Upper button = Next height up
+  *		Lower button = Next height down
+  *	Right buttons (8) = Claw
+  *		Left button = Open claw
+  *		Right button = Close claw
+  *	Right joystick (2) = Extender
   *
   */
 
@@ -53,126 +63,169 @@
 #define MAIN_CONTROLLER 1
 #define LOWER_LIFT_UP_BTN 6
 #define LOWER_LIFT_DOWN_BTN 5
+// Power holding up a raised lower lift, low enough for its motors to stall at indefinitely
+#define LOWER_LIFT_HOLD 15
 
 // Partner controller defines
 #define PARTNER_CONTROLLER 2
 #define UPPER_LIFT_EXT 2
 #define UPPER_LIFT_BTN 7
+#define LIFT_PRESET_BTN 5
+#define LIFT_STACK_BTN 6
 #define CLAW_BTN 8
 
 //Other value defines
-#define JOYSTICK_TOLERANCE 17
-#define POTENT_TOLERANCE 0.10
+#define RECORD_BAUD 115200
 
 
 // The functions we will need to use for the robot
 void handleDrive();
-void joystickDrive();
-void buttonDrive();
+bool joystickDrive();
+bool buttonDrive();
+int lowerLiftSpeed(unsigned char buttonGroup, bool *raised);
 void handleLowerLift();
 void handleUpperLift();
-void handleDirections(int reversed[], int numReversed);
-int toleranceCheck(int num, int tolerance);
+bool partnerTapped(unsigned char buttonGroup, unsigned char button);
 int isWithinTolerance(int num1, int num2, int tolerance);
 void debugPotents();
+void debugAutonomous();
+void debugProfile();
+void driverControlStart();
 
-// debug = 1 --> Print potent values and allow autonomous through button
+const Behavior driverControlBehavior = {"driver control", driverControlStart};
+
+// debug = 1 --> Allow autonomous through button and profile every tick
 int debug = 0;
+// telemetry = 1 --> Send potent values every tick, cheap enough to leave on in matches
+int telemetry = 1;
+// How the drive joysticks are mixed, DRIVE_TANK, DRIVE_ARCADE or DRIVE_CURVATURE
+DriveMode driveMode = DRIVE_TANK;
+// recordInputs = 1 --> Stream the joysticks to UART 1 every tick, for replaying in the simulation
+int recordInputs = 0;
 
 void operatorControl() {
+    if (recordInputs) {
+        usartInit(uart1, RECORD_BAUD, SERIAL_8N1);
+        joylogRecord(uart1, SCHED_PERIOD_MS);
+    }
+    // The runtime runs everything registered every 20 milliseconds, regardless of how long it
+    // takes, from the next tick on
+    runtimeSetBehavior(&driverControlBehavior);
+    runtimeWait();
+}
 
-    int reversedMotors[1] = {LOWER_LIFT_R};
-    int numReversedMotors = sizeof(reversedMotors) / sizeof(reversedMotors[0]);
-
-    while (1) {
-        setPotents();
-        if (debug)
-            debugPotents();
-
-        if (debug && joystickGetDigital(MAIN_CONTROLLER, 8, JOY_RIGHT)) {
-            autonomous();
-        }
-
-        handleDrive();
-        handleLowerLift();
-        handleUpperLift();
-
-        // Reverse the motors that are designated in reversedMotors
-        handleDirections(reversedMotors, numReversedMotors);
-        // Delay by 20 milliseconds to wait for joystick updates
-        delay(20);
+// Sets up the scheduler with everything driver control runs each tick
+void driverControlStart() {
+    // Every handler reads the joysticks as they were at the start of the tick
+    schedulerRegister(joylogUpdate, SCHED_HIGH);
+    if (telemetry) {
+        schedulerRegister(debugPotents, SCHED_LOW);
+    }
+    if (debug) {
+        profilerEnable(true);
+        schedulerRegister(debugAutonomous, SCHED_LOW);
+        schedulerRegister(debugProfile, SCHED_LOW);
     }
 
+    schedulerRegister(handleDrive, SCHED_HIGH);
+    schedulerRegister(handleLowerLift, SCHED_HIGH);
+    schedulerRegister(handleUpperLift, SCHED_HIGH);
+    // Runs lift presets, after the handlers have started or cancelled them
+    schedulerRegister(motionUpdate, SCHED_HIGH);
 }
 
+// Queue the potent values for the telemetry task, which sends them while the loop is idle
 void debugPotents() {
-    printf("Right: %f\n Left: %f\n", getRightPotent(), getLeftPotent());
-    if (getLeftPotent() - getRightPotent() > POTENT_TOLERANCE) {
-        printf("LEFT HIGHER THAN RIGHT\n");
-    }
-    else if (getRightPotent() - getLeftPotent() > POTENT_TOLERANCE) {
-        printf("RIGHT HIGHER THAN LEFT\n");
+    int left = getLeftPotentQ16();
+    int right = getRightPotentQ16();
+    telemetryLog(TELEMETRY_POTENTS, left, right, left - right);
+}
+
+// Run autonomous from the main controller while debugging. It comes back to driver control
+// once the routine finishes.
+void debugAutonomous() {
+    static bool wasPressed = false;
+    bool pressed = joyDigital(MAIN_CONTROLLER, 8, JOY_RIGHT);
+    if (pressed && !wasPressed)
+        runtimeSetBehavior(&autonomousBehavior);
+    wasPressed = pressed;
+}
+
+// Print how long each part of the tick takes from the main controller, and show it on the LCD
+void debugProfile() {
+    static bool wasPressed = false;
+    bool pressed = joyDigital(MAIN_CONTROLLER, 8, JOY_LEFT);
+    if (pressed && !wasPressed) {
+        profilerPrint();
     }
-    printf("=============\n");
+    wasPressed = pressed;
+
+    profilerShowLcd(LCD_PORT);
 }
 
-// Set the drive motors to their appropriate values
+// Set the drive motors to their appropriate values. The joysticks win over the buttons.
 void handleDrive() {
-    buttonDrive();
-    joystickDrive();
+    if (!joystickDrive() && !buttonDrive())
+        driveMixSet(DRIVE_TANK, 0, 0);
 }
 
-void joystickDrive() {
-    int ch2 = toleranceCheck(joystickGetAnalog(MAIN_CONTROLLER, 2), JOYSTICK_TOLERANCE);
-    int ch3 = toleranceCheck(joystickGetAnalog(MAIN_CONTROLLER, 3), JOYSTICK_TOLERANCE);
-
-    if (abs(ch2) > 0 || abs(ch3) > 0) {
-        motorSet(L_DRIVE, ch3);
-        motorSet(R_DRIVE, ch2);
+// Returns false if the joysticks are centered
+bool joystickDrive() {
+    // Shaped by the driver's profile, which also takes care of the deadband
+    int first;
+    int second;
+    if (driveMode == DRIVE_TANK) {
+        first = inputShapeAxis(MAIN_CONTROLLER, 3);
+        second = inputShapeAxis(MAIN_CONTROLLER, 2);
+    } else {
+        first = inputShapeAxis(MAIN_CONTROLLER, 2);
+        second = inputShapeAxis(MAIN_CONTROLLER, 1);
     }
+    if (first == 0 && second == 0)
+        return false;
+    driveMixSet(driveMode, first, second);
+    return true;
 }
 
-void buttonDrive() {
-    int lSpeed;
-    int rSpeed;
-    if (joystickGetDigital(MAIN_CONTROLLER, 7, JOY_UP)) {
-        lSpeed = 127;
-        rSpeed = 127;
-    } else if (joystickGetDigital(MAIN_CONTROLLER, 7, JOY_DOWN)) {
-        lSpeed = -127;
-        rSpeed = -127;
-    } else if (joystickGetDigital(MAIN_CONTROLLER, 7, JOY_RIGHT)) {
-        rSpeed = -127;
-        lSpeed = 127;
-    } else if (joystickGetDigital(MAIN_CONTROLLER, 7, JOY_LEFT)) {
-        rSpeed = 127;
-        lSpeed = -127;
-    } else {
-        lSpeed = 0;
-        rSpeed = 0;
+// Returns false if no drive button is pressed. Pressing a direction and a turn drives an arc.
+bool buttonDrive() {
+    int throttle = 0;
+    int turn = 0;
+    if (joyDigital(MAIN_CONTROLLER, 7, JOY_UP)) {
+        throttle = 127;
+    } else if (joyDigital(MAIN_CONTROLLER, 7, JOY_DOWN)) {
+        throttle = -127;
+    }
+    if (joyDigital(MAIN_CONTROLLER, 7, JOY_RIGHT)) {
+        turn = 127;
+    } else if (joyDigital(MAIN_CONTROLLER, 7, JOY_LEFT)) {
+        turn = -127;
     }
+    if (throttle == 0 && turn == 0)
+        return false;
+    driveMixSet(DRIVE_ARCADE, throttle, turn);
+    return true;
+}
 
-    motorSet(L_DRIVE, lSpeed);
-    motorSet(R_DRIVE, rSpeed);
+// Speed of one side of the lower lift. Once let go after raising it, the side holds its load
+// up with a little power; the lift has no sensor, so there is nothing to correct against.
+int lowerLiftSpeed(unsigned char buttonGroup, bool *raised) {
+    if (joyDigital(MAIN_CONTROLLER, buttonGroup, JOY_UP)) {
+        *raised = true;
+        return 127;
+    } else if (joyDigital(MAIN_CONTROLLER, buttonGroup, JOY_DOWN)) {
+        *raised = false;
+        return -64;
+    }
+    return *raised ? LOWER_LIFT_HOLD : 0;
 }
 
 // Set the lower lift motors to their appropriate values
 void handleLowerLift() {
-    if (joystickGetDigital(MAIN_CONTROLLER, 6, JOY_UP)) {
-        motorSet(LOWER_LIFT_R, 127);
-    } else if (joystickGetDigital(MAIN_CONTROLLER, 6, JOY_DOWN)) {
-        motorSet(LOWER_LIFT_R, -64);
-    } else {
-        motorStop(LOWER_LIFT_R);
-    }
-
-    if (joystickGetDigital(MAIN_CONTROLLER, 5, JOY_UP)) {
-        motorSet(LOWER_LIFT_L, 127);
-    } else if (joystickGetDigital(MAIN_CONTROLLER, 5, JOY_DOWN)) {
-        motorSet(LOWER_LIFT_L, -64);
-    } else {
-        motorStop(LOWER_LIFT_L);
-    }
+    static bool rightRaised = false;
+    static bool leftRaised = false;
+    motorFrameSet(LOWER_LIFT_R, lowerLiftSpeed(6, &rightRaised));
+    motorFrameSet(LOWER_LIFT_L, lowerLiftSpeed(5, &leftRaised));
 }
 
 // Upper lift functions
@@ -188,88 +241,75 @@ void handleUpperLift() {
     // Max height is roughly 1608
     // Smallest height is roughly -1
 
-    int rLiftSpeed = 0;
-    int lLiftSpeed = 0;
-
-    if (joystickGetDigital(PARTNER_CONTROLLER, UPPER_LIFT_BTN, JOY_UP)) {
-        // Move lift upwards
-
-        // If potentiometers are off, only move one.
-        if (getLeftPotent() - getRightPotent() > POTENT_TOLERANCE) {
-            // Left is more than right by roughly 8%
-            // So we should only move right side up
-            rLiftSpeed = getUpperRaiseSpeed();
-            lLiftSpeed = 0;
-        }
-        else if (getRightPotent() - getLeftPotent() > POTENT_TOLERANCE) {
-            // Right is more than left by roughly 8%
-            // So we should only move left side up
-            lLiftSpeed = getUpperRaiseSpeed();
-            rLiftSpeed = 0;
-        } else {
-            // Lifts are roughly the same height
-            // So they should be the same speed
-            rLiftSpeed = getUpperRaiseSpeed();
-            lLiftSpeed = rLiftSpeed;
-        }
-
-    } else if (joystickGetDigital(PARTNER_CONTROLLER, UPPER_LIFT_BTN, JOY_DOWN)) {
-        // Move lift downwards
+    // Presets go from where the lift is headed, so tapping twice goes up two heights
+    static int presetTarget = LIFT_BOTTOM;
+    int from = motionIsBusy(MOTION_UPPER_LIFT) ? presetTarget : liftPosition();
+    int target = -1;
+    // Every button is checked every tick, so each tap is only seen once
+    bool loader = partnerTapped(LIFT_PRESET_BTN, JOY_UP);
+    bool bottom = partnerTapped(LIFT_PRESET_BTN, JOY_DOWN);
+    bool stackUp = partnerTapped(LIFT_STACK_BTN, JOY_UP);
+    bool stackDown = partnerTapped(LIFT_STACK_BTN, JOY_DOWN);
+    if (loader) {
+        target = LIFT_LOADER;
+    } else if (bottom) {
+        target = LIFT_BOTTOM;
+    } else if (stackUp) {
+        target = liftStackAbove(from);
+    } else if (stackDown) {
+        target = liftStackBelow(from);
+    }
 
-        // If potentiometers are off, only move one.
-        if (getLeftPotent() - getRightPotent() > POTENT_TOLERANCE) {
-            // Left is more than right by roughly 8%
-            // So we should move both
-            rLiftSpeed = 0;
-            lLiftSpeed = getLowerRaiseSpeed();
-        }
-        else if (getRightPotent() - getLeftPotent() > POTENT_TOLERANCE) {
-            // Right is more than left by roughly 8%
-            // So we should only move right side down
-            lLiftSpeed = 0;
-            rLiftSpeed = getLowerRaiseSpeed();
-        } else {
-            // Lifts are roughly the same height
-            // So we should move both
-            rLiftSpeed = getLowerRaiseSpeed();
-            lLiftSpeed = rLiftSpeed;
-        }
+    int liftSpeed = 0;
+    if (joyDigital(PARTNER_CONTROLLER, UPPER_LIFT_BTN, JOY_UP)) {
+        liftSpeed = getUpperRaiseSpeed();
+    } else if (joyDigital(PARTNER_CONTROLLER, UPPER_LIFT_BTN, JOY_DOWN)) {
+        liftSpeed = getLowerRaiseSpeed();
     }
 
-    motorSet(UPPER_LIFT_L, lLiftSpeed);
-    motorSet(UPPER_LIFT_R, rLiftSpeed);
+    if (liftSpeed != 0) {
+        // Taking the lift over by hand cancels any preset. Only a running one, since stopping
+        // resets the sync controller, whose integral has to build up while lifting by hand.
+        if (motionIsBusy(MOTION_UPPER_LIFT))
+            motionStop(MOTION_UPPER_LIFT);
+        // Both sides run at this speed, with the sync controller keeping them level
+        liftDrive(liftSpeed);
+    } else if (target >= 0) {
+        // motionUpdate() drives the lift there from this tick on
+        presetTarget = target;
+        motionLiftTo(target, LIFT_PRESET_TIMEOUT);
+    } else if (!motionIsBusy(MOTION_UPPER_LIFT)) {
+        // Keeps the lift where it was let go or where the preset left it
+        liftHold();
+    }
 
     // Extender
-    int extenderSpeed = joystickGetAnalog(PARTNER_CONTROLLER, UPPER_LIFT_EXT);
-    motorSet(UPPER_EXT_L, extenderSpeed);
-    motorSet(UPPER_EXT_R, extenderSpeed);
+    int extenderSpeed = inputShapeAxis(PARTNER_CONTROLLER, UPPER_LIFT_EXT);
+    motorFrameSet(UPPER_EXT_L, extenderSpeed);
+    motorFrameSet(UPPER_EXT_R, extenderSpeed);
 
     // Claw
     int clawSpeed = 0;
-    if (joystickGetDigital(PARTNER_CONTROLLER, CLAW_BTN, JOY_LEFT)) {
+    if (joyDigital(PARTNER_CONTROLLER, CLAW_BTN, JOY_LEFT)) {
         clawSpeed = -67;
-    } else if (joystickGetDigital(PARTNER_CONTROLLER, CLAW_BTN, JOY_RIGHT)) {
+    } else if (joyDigital(PARTNER_CONTROLLER, CLAW_BTN, JOY_RIGHT)) {
         clawSpeed = 67;
     }
-    motorSet(CLAW, clawSpeed);
+    motorFrameSet(CLAW, clawSpeed);
 }
 
-// Reverse motors that need to be reversed
-void handleDirections(int reversed[], int numReversed) {
-    for (int i = 0; i < numReversed; i++) {
-        // Set motor i to the negative value of its current speed
-        int motor = reversed[i];
-        motorSet(motor, -1 * motorGet(motor));
-    }
-}
-
-// Check if number is above tolerance. If it is, return that number. If not, return 0.
-int toleranceCheck(int num, int tolerance) {
-    if (abs(num) > tolerance) {
-        return num;
-    } else {
-        return 0;
-    }
+// True on the tick a partner button goes down
+bool partnerTapped(unsigned char buttonGroup, unsigned char button) {
+    // The JOY_ button values are bits, one nibble per group from 5 to 8
+    static unsigned int held = 0;
+    unsigned int bit = (unsigned int)button << ((buttonGroup - 5) * 4);
+    bool pressed = joyDigital(PARTNER_CONTROLLER, buttonGroup, button);
+    bool tapped = pressed && !(held & bit);
+    if (pressed)
+        held |= bit;
+    else
+        held &= ~bit;
+    return tapped;
 }
 
 int isWithinTolerance(int num1, int num2, int tolerance) {
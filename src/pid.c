@@ -0,0 +1,68 @@
+/** @file pid.c
+ * @brief Integer PID/feedforward controller
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+void pidInit(Pid *pid, int kp, int ki, int kd, unsigned long periodMs) {
+    pid->kp = kp;
+    pid->ki = ki;
+    pid->kd = kd;
+    pid->kf = 0;
+    pid->periodMs = periodMs;
+    // Worked out once here, so updates never divide
+    pid->kiPerUpdate = ((long long)ki * (long)periodMs << PID_INTEGRAL_SHIFT) / 1000;
+    pid->kdPerUpdate = periodMs > 0 ? (long long)kd * 1000 / (long)periodMs : 0;
+    pidSetOutputLimit(pid, MOTOR_MAX_SPEED);
+    pidReset(pid);
+}
+
+void pidSetOutputLimit(Pid *pid, int limit) {
+    pid->outputLimit = limit;
+    // The integral term alone stays within the output limit
+    pid->maxIntegral = limit << (16 + PID_INTEGRAL_SHIFT);
+}
+
+void pidReset(Pid *pid) {
+    pid->integral = 0;
+    pid->hasLast = false;
+}
+
+int pidUpdate(Pid *pid, int setpoint, int measured) {
+    int error = setpoint - measured;
+    int limit = pid->outputLimit;
+
+    int output = pid->kp * error;
+    if (pid->kf != 0)
+        output += pid->kf * setpoint;
+
+    // Differentiate the measurement rather than the error so setpoint steps don't kick
+    if (pid->hasLast && pid->kdPerUpdate != 0)
+        output -= pid->kdPerUpdate * (measured - pid->lastMeasured);
+    pid->lastMeasured = measured;
+    pid->hasLast = true;
+
+    if (pid->kiPerUpdate != 0) {
+        int pd = output >> 16;
+        // Only integrate when it would not push an already saturated output further
+        if (!((pd >= limit && error > 0) || (pd <= -limit && error < 0)))
+            pid->integral += pid->kiPerUpdate * error;
+
+        if (pid->integral > pid->maxIntegral)
+            pid->integral = pid->maxIntegral;
+        else if (pid->integral < -pid->maxIntegral)
+            pid->integral = -pid->maxIntegral;
+
+        output += pid->integral >> PID_INTEGRAL_SHIFT;
+    }
+
+    output >>= 16;
+    if (output > limit)
+        return limit;
+    if (output < -limit)
+        return -limit;
+    return output;
+}
@@ -1,25 +1,51 @@
 #include "main.h"
+// Filtered readings and their rates of change, in analogReadCalibratedHR() units
 int lPotent = 0;
 int rPotent = 0;
+int lPotentRate = 0;
+int rPotentRate = 0;
 
+// Raw readings at the top of each side's travel, used to scale both sides to the same range
+#define LEFT_POTENT_RANGE 2000
+#define RIGHT_POTENT_RANGE 1720
+
+static int positive(int reading) {
+    if (reading > 0)
+        return reading;
+    return 0;
+}
+
+// Takes both potentiometers from the same sensor frame, once per tick
 void setPotents() {
-    lPotent = analogReadCalibrated(LEFT_POTENT);
-    rPotent = analogReadCalibrated(RIGHT_POTENT);
+    SensorFrame frame;
+    sensorsGet(&frame);
+    lPotent = frame.filtered[LEFT_POTENT];
+    rPotent = frame.filtered[RIGHT_POTENT];
+    lPotentRate = frame.rate[LEFT_POTENT];
+    rPotentRate = frame.rate[RIGHT_POTENT];
+}
+
+// Positions are Q16 fixed point, so POTENT_ONE is the top of the travel. Readings have 4 more
+// bits than raw counts, so shifting them by 12 more makes Q16 counts.
+// The ranges are constants, so the compiler turns these divisions into multiplies.
+int getLeftPotentQ16() {
+    return (positive(lPotent) << 12) / LEFT_POTENT_RANGE;
+}
+int getRightPotentQ16() {
+    return (positive(rPotent) << 12) / RIGHT_POTENT_RANGE;
 }
-float getLeftPotent() {
-    return (float)(getLeftPotentRaw()) / 2000;
+
+// Rates of change in Q16 positions per second
+int getLeftPotentRateQ16() {
+    return (lPotentRate << 12) / LEFT_POTENT_RANGE;
 }
-float getRightPotent() {
-    return (float)(getRightPotentRaw()) / 1720;
+int getRightPotentRateQ16() {
+    return (rPotentRate << 12) / RIGHT_POTENT_RANGE;
 }
 
 int getLeftPotentRaw() {
-    if (lPotent > 0)
-        return lPotent;
-    return 0;
+    return (positive(lPotent) + 8) >> 4;
 }
 int getRightPotentRaw() {
-    if (rPotent > 0)
-        return rPotent;
-    return 0;
+    return (positive(rPotent) + 8) >> 4;
 }
@@ -0,0 +1,208 @@
+/** @file profiler.c
+ * @brief Control loop profiler
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Ring samples are stored in units of 16 cycles, so the ring fits in 16 bits a sample and
+// saturates at 14.5 ms, far past a whole tick. The all-time statistics are exact.
+#define SAMPLE_SHIFT 4
+#define SAMPLE_MAX 0xFFFF
+
+// Cortex-M3 debug registers that run the cycle counter
+#define DEMCR (*(volatile unsigned long *)0xE000EDFC)
+#define DEMCR_TRCENA (1UL << 24)
+#define DWT_CTRL (*(volatile unsigned long *)0xE0001000)
+#define DWT_CTRL_CYCCNTENA 1UL
+#define DWT_CYCCNT (*(volatile unsigned long *)0xE0001004)
+
+typedef struct {
+    const char *name;
+    unsigned long count;
+    unsigned long min;
+    unsigned long max;
+    // Total of every duration, which takes years of ticks to overflow
+    unsigned long long total;
+    unsigned short samples[PROFILE_SAMPLES];
+    unsigned char next;
+} ProfileSection;
+
+static ProfileSection sections[PROFILE_MAX_SECTIONS];
+static int numSections = 0;
+// First section refused for lack of room
+static const char *overflow = NULL;
+static bool enabled = false;
+
+// Section on the LCD, the buttons last pressed, and ticks until the next redraw
+static int lcdSection = 0;
+static unsigned int lcdButtons = 0;
+static int lcdCountdown = 0;
+
+void profilerEnable(bool enable) {
+#ifndef SIMULATION
+    if (enable) {
+        DEMCR |= DEMCR_TRCENA;
+        DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+    }
+#endif
+    enabled = enable;
+}
+
+bool profilerIsEnabled() {
+    return enabled;
+}
+
+static bool sameName(const char *a, const char *b) {
+    while (*a != '\0' && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+int profilerSection(const char *name) {
+    for (int i = 0; i < numSections; i++) {
+        if (sameName(sections[i].name, name))
+            return i;
+    }
+    if (numSections == PROFILE_MAX_SECTIONS) {
+        if (overflow == NULL)
+            overflow = name;
+        return PROFILE_NONE;
+    }
+    sections[numSections].name = name;
+    sections[numSections].count = 0;
+    return numSections++;
+}
+
+#ifdef SIMULATION
+// Host time, since the simulation's virtual clock stands still while code runs
+unsigned long simCycles();
+#endif
+
+unsigned long profilerClock() {
+#ifdef SIMULATION
+    return simCycles();
+#else
+    return DWT_CYCCNT;
+#endif
+}
+
+void profilerRecord(int section, unsigned long cycles) {
+    if (section < 0 || section >= numSections)
+        return;
+    ProfileSection *s = &sections[section];
+    if (s->count == 0 || cycles < s->min)
+        s->min = cycles;
+    if (s->count == 0 || cycles > s->max)
+        s->max = cycles;
+    s->count++;
+    s->total += cycles;
+
+    unsigned long sample = cycles >> SAMPLE_SHIFT;
+    s->samples[s->next] = sample > SAMPLE_MAX ? SAMPLE_MAX : (unsigned short)sample;
+    s->next = (s->next + 1) % PROFILE_SAMPLES;
+}
+
+void profilerReset() {
+    for (int i = 0; i < numSections; i++) {
+        sections[i].count = 0;
+        sections[i].total = 0;
+        sections[i].next = 0;
+    }
+}
+
+const char *profilerOverflow() {
+    return overflow;
+}
+
+int profilerSections() {
+    return numSections;
+}
+
+// 99th percentile of the ring, by nearest rank
+static unsigned long percentile99(const ProfileSection *s) {
+    int n = s->count < PROFILE_SAMPLES ? (int)s->count : PROFILE_SAMPLES;
+    if (n == 0)
+        return 0;
+    // Only the top few samples matter, so keep just those, largest first
+    int keep = n - (n * 99 + 99) / 100 + 1;
+    unsigned short top[PROFILE_SAMPLES / 50 + 2];
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        unsigned short sample = s->samples[i];
+        int j = kept < keep ? kept++ : keep;
+        while (j > 0 && top[j - 1] < sample) {
+            if (j < keep)
+                top[j] = top[j - 1];
+            j--;
+        }
+        if (j < keep)
+            top[j] = sample;
+    }
+    return (unsigned long)top[keep - 1] << SAMPLE_SHIFT;
+}
+
+bool profilerGetStats(int section, ProfileStats *stats) {
+    if (section < 0 || section >= numSections)
+        return false;
+    const ProfileSection *s = &sections[section];
+    stats->name = s->name;
+    stats->count = s->count;
+    stats->min = s->count > 0 ? s->min : 0;
+    stats->max = s->count > 0 ? s->max : 0;
+    stats->average = s->count > 0 ? (unsigned long)(s->total / s->count) : 0;
+    stats->p99 = percentile99(s);
+    return true;
+}
+
+// Cycles to whole microseconds, rounded
+static unsigned int toMicros(unsigned long cycles) {
+    return (cycles + PROFILE_CYCLES_PER_US / 2) / PROFILE_CYCLES_PER_US;
+}
+
+void profilerPrint() {
+    printf("%-20s %8s %6s %6s %6s %6s (us)\n", "section", "count", "min", "avg", "max", "p99");
+    for (int i = 0; i < numSections; i++) {
+        ProfileStats stats;
+        profilerGetStats(i, &stats);
+        printf("%-20s %8lu %6u %6u %6u %6u\n", stats.name, stats.count, toMicros(stats.min),
+            toMicros(stats.average), toMicros(stats.max), toMicros(stats.p99));
+    }
+    if (overflow != NULL)
+        printf("%s and later sections not profiled, raise PROFILE_MAX_SECTIONS\n", overflow);
+}
+
+void profilerShowLcd(PROS_FILE *lcdPort) {
+    unsigned int buttons = lcdReadButtons(lcdPort);
+    unsigned int pressed = buttons & ~lcdButtons;
+    lcdButtons = buttons;
+
+    if (numSections == 0)
+        return;
+    if (pressed & LCD_BTN_LEFT)
+        lcdSection = (lcdSection + numSections - 1) % numSections;
+    if (pressed & LCD_BTN_RIGHT)
+        lcdSection = (lcdSection + 1) % numSections;
+    if (pressed & LCD_BTN_CENTER)
+        profilerReset();
+    if (pressed == 0 && --lcdCountdown > 0)
+        return;
+    lcdCountdown = PROFILE_LCD_TICKS;
+
+    // 16 characters a line: the name and average, then the worst cases
+    ProfileStats stats;
+    profilerGetStats(lcdSection % numSections, &stats);
+    char name[11];
+    int length = 0;
+    while (length < 10 && stats.name[length] != '\0') {
+        name[length] = stats.name[length];
+        length++;
+    }
+    name[length] = '\0';
+    lcdPrint(lcdPort, 1, "%-10s%5uu", name, toMicros(stats.average));
+    lcdPrint(lcdPort, 2, "99%% %4u max%4u", toMicros(stats.p99), toMicros(stats.max));
+}
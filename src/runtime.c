@@ -0,0 +1,83 @@
+/** @file runtime.c
+ * @brief Persistent control runtime
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+static void idleStart() {
+    motorFrameInit();
+}
+
+const Behavior idleBehavior = {"idle", idleStart};
+
+// Set from any task, and picked up by the control task between ticks
+static const Behavior *volatile requested = &idleBehavior;
+// Only the control task touches these
+static const Behavior *active = NULL;
+static const Behavior *previous = &idleBehavior;
+static TaskHandle runtimeTask = NULL;
+
+// Last callback of every tick. Catches a switch asked for while the tick was being set up.
+static void runtimeCheck() {
+    // The kernel has stopped the mode's task, which will pick a behavior again when enabled
+    if (!isEnabled())
+        requested = &idleBehavior;
+    if (requested != active)
+        schedulerStop();
+}
+
+static void runtimeLoop(void *ignore) {
+    while (1) {
+        const Behavior *behavior = requested;
+        if (behavior != active) {
+            previous = active != NULL ? active : &idleBehavior;
+            active = behavior;
+        }
+        // Whatever the last behavior left moving is stopped before the next one takes over
+        motionInit();
+
+        schedulerInit(SCHED_PERIOD_MS);
+        schedulerRegister(eventsDispatch, SCHED_HIGH);
+        schedulerRegister(setPotents, SCHED_HIGH);
+        behavior->start();
+        // Send this tick's motor commands, once per motor
+        schedulerRegister(motorFrameFlush, SCHED_HIGH);
+        // Remember what was sent, for working out what went wrong after the match
+        schedulerRegister(blackboxRecord, SCHED_HIGH);
+        schedulerRegister(runtimeCheck, SCHED_HIGH);
+
+        // Returns at the tick boundary after a switch
+        schedulerRun();
+    }
+}
+
+void runtimeStart() {
+    if (runtimeTask != NULL)
+        return;
+    motorFrameInit();
+    liftInit();
+    runtimeTask = taskCreate(runtimeLoop, TASK_DEFAULT_STACK_SIZE, NULL, RUNTIME_TASK_PRIORITY);
+}
+
+void runtimeSetBehavior(const Behavior *behavior) {
+    requested = behavior;
+    // The scheduler returns at the next tick boundary and the runtime switches there
+    if (behavior != active)
+        schedulerStop();
+}
+
+void runtimeFinish() {
+    runtimeSetBehavior(previous);
+}
+
+const Behavior *runtimeBehavior() {
+    return active;
+}
+
+void runtimeWait() {
+    while (1)
+        delay(RUNTIME_MODE_WAIT_MS);
+}
@@ -0,0 +1,111 @@
+/** @file scheduler.c
+ * @brief Fixed-rate control loop scheduler
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+typedef struct {
+    SchedCallback callback;
+    unsigned char priority;
+    int section;
+} SchedEntry;
+
+static SchedEntry entries[SCHED_MAX_CALLBACKS];
+static int numEntries = 0;
+static unsigned long period = SCHED_PERIOD_MS;
+static bool degraded = false;
+static bool stopped = false;
+static SchedStats stats;
+static int tickSection = PROFILE_NONE;
+
+void schedulerInit(unsigned long periodMs) {
+    numEntries = 0;
+    period = periodMs;
+    degraded = false;
+    stopped = false;
+    SchedStats empty = {0};
+    stats = empty;
+    tickSection = profilerSection("tick");
+}
+
+bool schedulerRegisterNamed(SchedCallback callback, const char *name, unsigned char priority) {
+    if (numEntries >= SCHED_MAX_CALLBACKS)
+        return false;
+    entries[numEntries].callback = callback;
+    entries[numEntries].priority = priority;
+    entries[numEntries].section = profilerSection(name);
+    numEntries++;
+    return true;
+}
+
+void schedulerRun() {
+    unsigned long periodUs = period * 1000;
+    unsigned long wakeTime = millis();
+    unsigned long expected = micros();
+
+    stopped = false;
+    while (!stopped) {
+        unsigned long start = micros();
+        long jitter = (long)(start - expected);
+        // Recorded before resynchronising, so the worst stalls show up in the stats
+        stats.lastJitter = jitter;
+        if (jitter > stats.maxJitter)
+            stats.maxJitter = jitter;
+
+        // Missed at least a whole tick, so start counting from now instead of catching up
+        if (jitter >= (long)periodUs) {
+            stats.missedTicks += jitter / periodUs;
+            expected = start;
+            wakeTime = millis();
+        }
+
+        // Checked once a tick, so disabled profiling costs one test a callback
+        bool profiling = profilerIsEnabled();
+        unsigned long tickStart = profiling ? profilerClock() : 0;
+        for (int i = 0; i < numEntries; i++) {
+            if (degraded && entries[i].priority == SCHED_LOW)
+                continue;
+            if (profiling) {
+                unsigned long callbackStart = profilerClock();
+                entries[i].callback();
+                profilerRecord(entries[i].section, profilerClock() - callbackStart);
+            } else {
+                entries[i].callback();
+            }
+        }
+        if (profiling)
+            profilerRecord(tickSection, profilerClock() - tickStart);
+
+        unsigned long end = micros();
+        stats.ticks++;
+        stats.lastDuration = end - start;
+        if (stats.lastDuration > stats.maxDuration)
+            stats.maxDuration = stats.lastDuration;
+        if (degraded)
+            stats.degradedTicks++;
+
+        // Overran if this tick ended after the next one should have started
+        degraded = end - expected > periodUs;
+        if (degraded)
+            stats.overruns++;
+
+        expected += periodUs;
+        if (!stopped)
+            taskDelayUntil(&wakeTime, period);
+    }
+}
+
+void schedulerStop() {
+    stopped = true;
+}
+
+void schedulerGetStats(SchedStats *out) {
+    *out = stats;
+}
+
+bool schedulerIsDegraded() {
+    return degraded;
+}
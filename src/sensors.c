@@ -0,0 +1,341 @@
+/** @file sensors.c
+ * @brief Background sensor acquisition task
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// Both potentiometers are averaged over 16 ms, less than one control tick
+const SensorFilter sensorFilters[BOARD_NR_ADC_PINS + 1] = {
+    [LEFT_POTENT] = {SENSOR_FILTER_AVERAGE, 16},
+    [RIGHT_POTENT] = {SENSOR_FILTER_AVERAGE, 16},
+};
+
+// Both potentiometers read zero with the lift resting at the bottom
+const bool sensorCalibrated[BOARD_NR_ADC_PINS + 1] = {
+    [LEFT_POTENT] = true,
+    [RIGHT_POTENT] = true,
+};
+
+// Filter state of one analog channel
+typedef struct {
+    // Last samples, for the moving average and median
+    int window[SENSOR_FILTER_MAX];
+    int count;
+    int next;
+    long sum;
+    // IIR output with 8 extra bits, so small steps aren't lost to rounding
+    long iir;
+    // Last filtered values, for the rate of change
+    int history[SENSOR_RATE_SAMPLES];
+    int historyCount;
+    int historyNext;
+} ChannelFilter;
+
+static ChannelFilter channelFilters[BOARD_NR_ADC_PINS + 1];
+static SensorFrame buffers[2];
+// Frames published so far. The newest frame is in buffers[published & 1].
+static volatile unsigned long published = 0;
+static unsigned long period = SENSOR_PERIOD_MS;
+static TaskHandle sensorTask = NULL;
+// Set by the calibration task once gyroInit() has calibrated the gyro
+static volatile Gyro gyro = NULL;
+
+// Subtracted from each channel's reading, in analogReadCalibratedHR() units. Only the sensor
+// task reads these, and a whole int is written at once.
+static volatile int offsets[BOARD_NR_ADC_PINS + 1];
+static volatile SensorCalibration calibrationStatus = SENSOR_CALIBRATION_CACHED;
+static volatile bool calibrationCheck = false;
+static volatile bool calibrationRequested = false;
+static TaskHandle calibrationTask = NULL;
+
+static int median(const int *window, int count) {
+    int sorted[SENSOR_FILTER_MAX];
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        while (j > 0 && sorted[j - 1] > window[i]) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = window[i];
+    }
+    return sorted[count / 2];
+}
+
+static int filter(ChannelFilter *state, const SensorFilter *config, int sample) {
+    int length = config->length;
+    if (length > SENSOR_FILTER_MAX)
+        length = SENSOR_FILTER_MAX;
+
+    switch (config->type) {
+    case SENSOR_FILTER_AVERAGE:
+    case SENSOR_FILTER_MEDIAN:
+        if (length < 1)
+            return sample;
+        if (state->count == length)
+            state->sum -= state->window[state->next];
+        else
+            state->count++;
+        state->window[state->next] = sample;
+        state->sum += sample;
+        state->next = (state->next + 1) % length;
+        if (config->type == SENSOR_FILTER_MEDIAN)
+            return median(state->window, state->count);
+        return state->sum / state->count;
+    case SENSOR_FILTER_IIR:
+        // Starts at the first sample instead of climbing up from zero
+        if (state->count == 0) {
+            state->iir = (long)sample << 8;
+            state->count = 1;
+        }
+        state->iir += (((long)sample << 8) - state->iir) >> length;
+        return state->iir >> 8;
+    default:
+        return sample;
+    }
+}
+
+// Change across the last SENSOR_RATE_SAMPLES filtered values, per second
+static int rateOfChange(ChannelFilter *state, int value) {
+    int rate = 0;
+    if (state->historyCount == SENSOR_RATE_SAMPLES) {
+        int oldest = state->history[state->historyNext];
+        rate = (value - oldest) * 1000 / (int)(SENSOR_RATE_SAMPLES * period);
+    } else {
+        state->historyCount++;
+    }
+    state->history[state->historyNext] = value;
+    state->historyNext = (state->historyNext + 1) % SENSOR_RATE_SAMPLES;
+    return rate;
+}
+
+// Fills the unpublished buffer and then makes it the published one
+static void sample() {
+    unsigned long next = published + 1;
+    SensorFrame *frame = &buffers[next & 1];
+
+    frame->sequence = next;
+    frame->time = micros();
+    for (int channel = 1; channel <= BOARD_NR_ADC_PINS; channel++) {
+        int sample = (analogRead(channel) << 4) - offsets[channel];
+        ChannelFilter *state = &channelFilters[channel];
+        frame->analog[channel] = (sample + 8) >> 4;
+        frame->filtered[channel] = filter(state, &sensorFilters[channel], sample);
+        frame->rate[channel] = rateOfChange(state, frame->filtered[channel]);
+    }
+
+    unsigned int digital = 0;
+    for (int pin = 1; pin <= SENSOR_DIGITAL_PINS; pin++) {
+        if (digitalRead(pin))
+            digital |= 1 << pin;
+    }
+    frame->digital = digital;
+
+    unsigned int imeValid = 0;
+    for (int address = 0; address < SENSOR_IMES; address++) {
+        if (imeGet(address, &frame->ime[address]))
+            imeValid |= 1 << address;
+    }
+    frame->imeValid = imeValid;
+    Gyro started = gyro;
+    frame->gyroValid = started != NULL;
+    frame->gyro = started != NULL ? gyroGet(started) : 0;
+
+    // The frame has to be complete in memory before readers can pick it
+    __sync_synchronize();
+    published = next;
+}
+
+static unsigned int checksum(const unsigned char *bytes, int length) {
+    unsigned int sum = 0;
+    for (int i = 0; i < length; i++)
+        sum = ((sum << 1) | (sum >> 15)) + bytes[i];
+    return sum & 0xFFFF;
+}
+
+/*
+ * Calibration file: 'C', 'A', SENSOR_CALIBRATION_VERSION, the number of channels, each
+ * channel's offset in 32 bits little-endian, and a 16 bit checksum of everything before it.
+ */
+static bool loadCalibration(int *loaded) {
+    PROS_FILE *stream = fopen(SENSOR_CALIBRATION_FILE, "r");
+    if (stream == NULL)
+        return false;
+    unsigned char bytes[SENSOR_CALIBRATION_BYTES];
+    size_t length = fread(bytes, 1, sizeof(bytes), stream);
+    fclose(stream);
+
+    int end = SENSOR_CALIBRATION_BYTES - 2;
+    if (length != sizeof(bytes) || bytes[0] != 'C' || bytes[1] != 'A' ||
+        bytes[2] != SENSOR_CALIBRATION_VERSION || bytes[3] != BOARD_NR_ADC_PINS ||
+        checksum(bytes, end) != (bytes[end] | (unsigned int)bytes[end + 1] << 8))
+        return false;
+    for (int channel = 1; channel <= BOARD_NR_ADC_PINS; channel++) {
+        const unsigned char *offset = &bytes[4 * channel];
+        loaded[channel] = (int)(offset[0] | (unsigned long)offset[1] << 8 |
+            (unsigned long)offset[2] << 16 | (unsigned long)offset[3] << 24);
+    }
+    return true;
+}
+
+static bool saveCalibration() {
+    unsigned char bytes[SENSOR_CALIBRATION_BYTES] = {'C', 'A', SENSOR_CALIBRATION_VERSION,
+        BOARD_NR_ADC_PINS};
+    for (int channel = 1; channel <= BOARD_NR_ADC_PINS; channel++) {
+        unsigned long offset = offsets[channel];
+        bytes[4 * channel] = offset;
+        bytes[4 * channel + 1] = offset >> 8;
+        bytes[4 * channel + 2] = offset >> 16;
+        bytes[4 * channel + 3] = offset >> 24;
+    }
+    int end = SENSOR_CALIBRATION_BYTES - 2;
+    unsigned int sum = checksum(bytes, end);
+    bytes[end] = sum;
+    bytes[end + 1] = sum >> 8;
+
+    PROS_FILE *stream = fopen(SENSOR_CALIBRATION_FILE, "w");
+    if (stream == NULL)
+        return false;
+    size_t length = fwrite(bytes, 1, sizeof(bytes), stream);
+    fclose(stream);
+    return length == sizeof(bytes);
+}
+
+/*
+ * Averages SENSOR_CALIBRATION_SAMPLES raw samples of each calibrated channel into an offset.
+ * In the background, where nobody is making sure the robot is still, gives up if a channel moves
+ * more than SENSOR_CALIBRATION_STILL or the robot is enabled.
+ */
+static bool measure(int *measured, bool background) {
+    long total[BOARD_NR_ADC_PINS + 1] = {0};
+    int low[BOARD_NR_ADC_PINS + 1];
+    int high[BOARD_NR_ADC_PINS + 1];
+    for (int i = 0; i < SENSOR_CALIBRATION_SAMPLES; i++) {
+        if (background && isEnabled())
+            return false;
+        for (int channel = 1; channel <= BOARD_NR_ADC_PINS; channel++) {
+            if (!sensorCalibrated[channel])
+                continue;
+            int value = analogRead(channel);
+            total[channel] += value;
+            if (i == 0 || value < low[channel])
+                low[channel] = value;
+            if (i == 0 || value > high[channel])
+                high[channel] = value;
+        }
+        delay(1);
+    }
+    for (int channel = 1; channel <= BOARD_NR_ADC_PINS; channel++) {
+        if (!sensorCalibrated[channel]) {
+            measured[channel] = 0;
+            continue;
+        }
+        if (background && high[channel] - low[channel] > SENSOR_CALIBRATION_STILL)
+            return false;
+        measured[channel] = (total[channel] * 16 + SENSOR_CALIBRATION_SAMPLES / 2) /
+            SENSOR_CALIBRATION_SAMPLES;
+    }
+    return true;
+}
+
+static bool applyCalibration(const int *measured) {
+    for (int channel = 1; channel <= BOARD_NR_ADC_PINS; channel++)
+        offsets[channel] = measured[channel];
+    calibrationStatus = SENSOR_CALIBRATION_MEASURED;
+    return saveCalibration();
+}
+
+bool sensorsCalibrate() {
+    int measured[BOARD_NR_ADC_PINS + 1];
+    measure(measured, false);
+    calibrationRequested = false;
+    calibrationCheck = false;
+    return applyCalibration(measured);
+}
+
+void sensorsRequestCalibration() {
+    calibrationRequested = true;
+}
+
+SensorCalibration sensorsCalibrationStatus() {
+    return calibrationStatus;
+}
+
+static bool calibrationMoved(const int *measured) {
+    for (int channel = 1; channel <= BOARD_NR_ADC_PINS; channel++) {
+        int change = measured[channel] - offsets[channel];
+        if (change > SENSOR_CALIBRATION_TOLERANCE || change < -SENSOR_CALIBRATION_TOLERANCE)
+            return true;
+    }
+    return false;
+}
+
+// Starts the gyro, then checks or redoes the offsets while the robot is disabled, when files may
+// be written
+static void calibrationLoop(void *ignore) {
+    // gyroInit() samples the gyro's zero for about a second, which would hold up initialize()
+    gyro = gyroInit(GYRO_PORT, 0);
+    while (1) {
+        if ((calibrationCheck || calibrationRequested) && !isEnabled()) {
+            int measured[BOARD_NR_ADC_PINS + 1];
+            if (measure(measured, true)) {
+                // Offsets within the tolerance stay as they are, so the file isn't rewritten
+                // every boot. Ones that moved are only flagged: the lift may just be resting
+                // somewhere other than the bottom, such as after a reset in the middle of a match.
+                if (calibrationRequested)
+                    applyCalibration(measured);
+                else if (calibrationMoved(measured))
+                    calibrationStatus = SENSOR_CALIBRATION_MISMATCH;
+                else
+                    calibrationStatus = SENSOR_CALIBRATION_CHECKED;
+                calibrationRequested = false;
+                calibrationCheck = false;
+            }
+        }
+        delay(SENSOR_CALIBRATION_CHECK_MS);
+    }
+}
+
+static void sensorLoop(void *ignore) {
+    unsigned long wakeTime = millis();
+    while (1) {
+        sample();
+        taskDelayUntil(&wakeTime, period);
+    }
+}
+
+void sensorsStart(unsigned long periodMs) {
+    if (sensorTask != NULL)
+        return;
+    period = periodMs;
+    imeInitializeAll();
+
+    int loaded[BOARD_NR_ADC_PINS + 1];
+    if (loadCalibration(loaded)) {
+        for (int channel = 1; channel <= BOARD_NR_ADC_PINS; channel++)
+            offsets[channel] = sensorCalibrated[channel] ? loaded[channel] : 0;
+        calibrationStatus = SENSOR_CALIBRATION_CACHED;
+        calibrationCheck = true;
+    } else {
+        sensorsCalibrate();
+    }
+
+    // Publish a frame now so readers never see an empty one
+    sample();
+    sensorTask = taskCreate(sensorLoop, TASK_DEFAULT_STACK_SIZE, NULL, SENSOR_TASK_PRIORITY);
+    calibrationTask = taskCreate(calibrationLoop, TASK_DEFAULT_STACK_SIZE, NULL,
+        SENSOR_CALIBRATION_TASK_PRIORITY);
+}
+
+void sensorsGet(SensorFrame *frame) {
+    unsigned long sequence;
+    do {
+        sequence = published;
+        __sync_synchronize();
+        *frame = buffers[sequence & 1];
+        __sync_synchronize();
+        // Once another frame is published, the task starts refilling the buffer just copied
+    } while (sequence != published);
+}
@@ -0,0 +1,121 @@
+/** @file telemetry.c
+ * @brief Binary telemetry channel
+ *
+ * Any copyright is dedicated to the Public Domain.
+ * http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "main.h"
+
+// A COBS frame of a record, with its code byte and zero delimiter
+#define FRAME_BYTES (TELEMETRY_RECORD_BYTES + 2)
+
+static TelemetryRecord ring[TELEMETRY_RING_RECORDS];
+// Records ever written and read. Only the producer moves head and only the consumer moves tail.
+static volatile unsigned long head = 0;
+static volatile unsigned long tail = 0;
+static volatile unsigned long dropped = 0;
+
+static PROS_FILE *output = NULL;
+static TaskHandle telemetryTask = NULL;
+
+bool telemetryLog(unsigned char type, long a, long b, long c) {
+    unsigned long next = head;
+    if (next - tail >= TELEMETRY_RING_RECORDS) {
+        dropped++;
+        return false;
+    }
+    TelemetryRecord *record = &ring[next % TELEMETRY_RING_RECORDS];
+    record->type = type;
+    record->time = millis();
+    record->values[0] = a;
+    record->values[1] = b;
+    record->values[2] = c;
+    // The record has to be complete in memory before the drain task can see it
+    __sync_synchronize();
+    head = next + 1;
+    return true;
+}
+
+unsigned long telemetryDropped() {
+    return dropped;
+}
+
+static void putLong(unsigned char *bytes, unsigned long value) {
+    bytes[0] = value;
+    bytes[1] = value >> 8;
+    bytes[2] = value >> 16;
+    bytes[3] = value >> 24;
+}
+
+/*
+ * Consistent Overhead Byte Stuffing: every zero byte is replaced by the distance to the next
+ * one, with a leading code byte for the first, so the only zero in the frame is its delimiter.
+ * Records are shorter than 254 bytes, so one code byte per zero is always enough.
+ */
+static int encodeFrame(const TelemetryRecord *record, unsigned char *frame) {
+    unsigned char bytes[TELEMETRY_RECORD_BYTES] = {0};
+    bytes[0] = record->type;
+    putLong(&bytes[4], record->time);
+    for (int i = 0; i < TELEMETRY_VALUES; i++)
+        putLong(&bytes[8 + 4 * i], record->values[i]);
+
+    int code = 0;
+    int length = 1;
+    for (int i = 0; i < TELEMETRY_RECORD_BYTES; i++) {
+        if (bytes[i] == 0) {
+            frame[code] = length - code;
+            code = length++;
+        } else {
+            frame[length++] = bytes[i];
+        }
+    }
+    frame[code] = length - code;
+    frame[length++] = 0;
+    return length;
+}
+
+static void writeRecord(const TelemetryRecord *record) {
+    unsigned char frame[FRAME_BYTES];
+    int length = encodeFrame(record, frame);
+    fwrite(frame, 1, length, output);
+}
+
+static void telemetryLoop(void *ignore) {
+    unsigned long reported = 0;
+    while (1) {
+        while (tail != head) {
+            __sync_synchronize();
+            // Copy the record out before giving its slot back to the producer
+            TelemetryRecord record = ring[tail % TELEMETRY_RING_RECORDS];
+            __sync_synchronize();
+            tail++;
+            writeRecord(&record);
+        }
+
+        unsigned long drops = dropped;
+        if (drops != reported) {
+            TelemetryRecord record = {TELEMETRY_DROPPED, millis(), {drops - reported, 0, 0}};
+            writeRecord(&record);
+            reported = drops;
+        }
+        delay(TELEMETRY_PERIOD_MS);
+    }
+}
+
+#ifdef SIMULATION
+// Keeps the binary frames out of the simulation's report on stdout
+PROS_FILE *simTelemetryStream();
+#endif
+
+void telemetryStart(PROS_FILE *stream) {
+    if (telemetryTask != NULL)
+        return;
+#ifdef SIMULATION
+    if (stream == stdout)
+        stream = simTelemetryStream();
+#endif
+    output = stream;
+    telemetryTask = taskCreate(telemetryLoop, TASK_DEFAULT_STACK_SIZE, NULL,
+        TELEMETRY_TASK_PRIORITY);
+}
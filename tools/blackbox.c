@@ -0,0 +1,91 @@
+/** @file blackbox.c
+ * @brief Host decoder of the robot's black box recordings
+ *
+ * Reads a file written by the black box, copied off the Cortex's file system, and prints one CSV
+ * row per sample, oldest first. The format is described in include/blackbox.h.
+ *
+ * Usage: blackbox < bbdrive > bbdrive.csv
+ */
+
+#include <stdio.h>
+
+// Must match include/blackbox.h
+#define BLACKBOX_VERSION 1
+#define BLACKBOX_FIELDS 22
+
+static const char *reasons[] = {"disabled", "scheduler overrun", "low battery",
+    "motion timeout"};
+
+static const char *columnNames = "time,analog1,analog2,analog3,analog4,digital,leftIme,rightIme,"
+    "gyro,motor1,motor2,motor3,motor4,motor5,motor6,motor7,motor8,motor9,motor10,"
+    "enabled,autonomous,online,degraded,battery,backup";
+
+// Reads a zigzag varint, returning 0 and setting ok to 0 at the end of the file
+static long long getVarint(int *ok) {
+    unsigned long long zigzag = 0;
+    int shift = 0;
+    int c;
+    do {
+        c = getchar();
+        if (c == EOF || shift > 63) {
+            *ok = 0;
+            return 0;
+        }
+        zigzag |= (unsigned long long)(c & 0x7F) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    return (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+}
+
+int main() {
+    int header[8];
+    for (int i = 0; i < 8; i++)
+        header[i] = getchar();
+    if (header[0] != 'B' || header[1] != 'B') {
+        fprintf(stderr, "not a black box recording\n");
+        return 1;
+    }
+    if (header[2] != BLACKBOX_VERSION || header[7] != BLACKBOX_FIELDS) {
+        fprintf(stderr, "unsupported recording version %d with %d fields\n", header[2],
+            header[7]);
+        return 1;
+    }
+    int reason = header[3];
+    int count = header[5] | header[6] << 8;
+    printf("# %s, %d samples every %d ms\n",
+        reason >= 0 && reason < 4 ? reasons[reason] : "unknown reason", count, header[4]);
+    printf("%s\n", columnNames);
+
+    long long fields[BLACKBOX_FIELDS] = {0};
+    int ok = 1;
+    for (int sample = 0; sample < count; sample++) {
+        int mask = getchar();
+        mask |= getchar() << 8;
+        int top = getchar();
+        if (top == EOF) {
+            fprintf(stderr, "recording ends after %d of %d samples\n", sample, count);
+            return 1;
+        }
+        mask |= top << 16;
+        for (int field = 0; field < BLACKBOX_FIELDS; field++) {
+            if (mask & (1 << field))
+                fields[field] += getVarint(&ok);
+        }
+        if (!ok) {
+            fprintf(stderr, "recording ends inside sample %d\n", sample);
+            return 1;
+        }
+
+        // Every field but the competition state, which is split into its bits
+        for (int field = 0; field < BLACKBOX_FIELDS; field++) {
+            if (field == 19) {
+                for (int bit = 0; bit < 4; bit++)
+                    printf(",%d", (int)(fields[field] >> bit) & 1);
+            } else {
+                printf(field == 0 ? "%lld" : ",%lld", fields[field]);
+            }
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+/** @file joylog.c
+ * @brief Host converter between joystick logs and CSV
+ *
+ * decode turns a log recorded by the robot, such as a capture of UART 1 with recordInputs set,
+ * into one CSV row per stretch of ticks the joysticks held still for. encode turns such a CSV back
+ * into a log, so inputs for the simulation's --replay can be edited or written by hand. A capture
+ * holding several logs, one per time driver control started, decodes to one table each.
+ *
+ * Columns: ticks, axes 1 to 4 of the main and then the partner joystick, and button groups 5 to
+ * 8 of the main and then the partner joystick, each as a JOY_DOWN 1 | JOY_LEFT 2 | JOY_UP 4 |
+ * JOY_RIGHT 8 mask. The format is described in include/joylog.h.
+ *
+ * Usage: joylog decode < log > inputs.csv
+ *        joylog encode [period ms] < inputs.csv > log
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Must match include/joylog.h
+#define JOYLOG_VERSION 1
+#define JOYLOG_FIELDS 12
+#define JOYLOG_MAX_RUN 127
+#define JOYLOG_DIGITAL_FIELD 8
+
+#define COLUMNS 16
+
+static const char *columnNames = "ticks,main1,main2,main3,main4,partner1,partner2,partner3,"
+    "partner4,main5,main6,main7,main8,partner5,partner6,partner7,partner8";
+
+// Unpacks the fields of one tick into the 16 CSV values after the tick count
+static void toColumns(const unsigned char *fields, int *columns) {
+    for (int i = 0; i < 8; i++)
+        columns[i] = (signed char)fields[i];
+    for (int i = 0; i < 8; i++) {
+        int field = fields[JOYLOG_DIGITAL_FIELD + i / 2];
+        columns[8 + i] = (field >> ((i & 1) * 4)) & 0x0F;
+    }
+}
+
+// Group 5 goes in the low nibble of the first field, 6 the high, 7 the low of the second...
+static void toFields(const int *columns, unsigned char *fields) {
+    for (int i = 0; i < 8; i++)
+        fields[i] = (unsigned char)columns[i];
+    for (int i = 0; i < 4; i++)
+        fields[JOYLOG_DIGITAL_FIELD + i] = 0;
+    for (int i = 0; i < 8; i++)
+        fields[JOYLOG_DIGITAL_FIELD + i / 2] |= (columns[8 + i] & 0x0F) << ((i & 1) * 4);
+}
+
+static void printRow(long ticks, const unsigned char *fields) {
+    int columns[COLUMNS];
+    toColumns(fields, columns);
+    printf("%ld", ticks);
+    for (int i = 0; i < COLUMNS; i++)
+        printf(",%d", columns[i]);
+    printf("\n");
+}
+
+static int decode() {
+    unsigned char fields[JOYLOG_FIELDS];
+    long held = 0;
+    int logs = 0;
+    int c;
+
+    while ((c = getchar()) != EOF) {
+        if (c == 'J') {
+            // Header of the next log
+            getchar();
+            int version = getchar();
+            int period = getchar();
+            if (version != JOYLOG_VERSION) {
+                fprintf(stderr, "unsupported log version %d\n", version);
+                return 1;
+            }
+            if (held > 0)
+                printRow(held, fields);
+            if (logs++ > 0)
+                printf("\n");
+            printf("# period %d ms\n%s\n", period, columnNames);
+            memset(fields, 0, sizeof(fields));
+            held = 0;
+        } else if (logs == 0) {
+            fprintf(stderr, "not a joystick log\n");
+            return 1;
+        } else if (c & 0x80) {
+            held += c & JOYLOG_MAX_RUN;
+        } else {
+            if (held > 0)
+                printRow(held, fields);
+            int mask = (c << 8) | getchar();
+            for (int i = 0; i < JOYLOG_FIELDS; i++) {
+                if (mask & (1 << i))
+                    fields[i] = (unsigned char)getchar();
+            }
+            held = 1;
+        }
+    }
+    if (held > 0)
+        printRow(held, fields);
+    return 0;
+}
+
+static void writeRun(long ticks) {
+    while (ticks > 0) {
+        long run = ticks < JOYLOG_MAX_RUN ? ticks : JOYLOG_MAX_RUN;
+        putchar(0x80 | run);
+        ticks -= run;
+    }
+}
+
+static int encode(int period) {
+    unsigned char fields[JOYLOG_FIELDS];
+    unsigned char last[JOYLOG_FIELDS] = {0};
+    char line[256];
+    int lineNumber = 0;
+
+    putchar('J');
+    putchar('L');
+    putchar(JOYLOG_VERSION);
+    putchar(period);
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        lineNumber++;
+        // Skip comments, blank lines and the column names
+        if (line[0] != '-' && (line[0] < '0' || line[0] > '9'))
+            continue;
+        long ticks;
+        int columns[COLUMNS];
+        char *next = line;
+        ticks = strtol(next, &next, 10);
+        for (int i = 0; i < COLUMNS; i++) {
+            if (*next != ',') {
+                fprintf(stderr, "line %d: expected %d columns\n", lineNumber, COLUMNS + 1);
+                return 1;
+            }
+            columns[i] = strtol(next + 1, &next, 10);
+        }
+        if (ticks < 1)
+            continue;
+        toFields(columns, fields);
+
+        int mask = 0;
+        for (int i = 0; i < JOYLOG_FIELDS; i++) {
+            if (fields[i] != last[i])
+                mask |= 1 << i;
+        }
+        if (mask == 0) {
+            writeRun(ticks);
+            continue;
+        }
+        putchar(mask >> 8);
+        putchar(mask & 0xFF);
+        for (int i = 0; i < JOYLOG_FIELDS; i++) {
+            if (mask & (1 << i))
+                putchar(fields[i]);
+        }
+        memcpy(last, fields, sizeof(last));
+        writeRun(ticks - 1);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "decode") == 0)
+        return decode();
+    if (argc >= 2 && strcmp(argv[1], "encode") == 0)
+        return encode(argc >= 3 ? atoi(argv[2]) : 20);
+    fprintf(stderr, "usage: joylog decode < log > inputs.csv\n"
+        "       joylog encode [period ms] < inputs.csv > log\n");
+    return 2;
+}
@@ -0,0 +1,87 @@
+/** @file potbench.c
+ * @brief Host benchmark of the potentiometer float path against the Q16 fixed-point path
+ *
+ * Runs the work handleUpperLift() does each tick both ways: the old float getters divided by
+ * 2000.0 and 1720.0 and compared against a 0.10 tolerance, and the Q16 getters compared against
+ * POTENT_ONE / 10. On the Cortex-M3 every float operation is a soft-float library call, so the
+ * gap on the robot is much larger than on a host with a hardware FPU.
+ *
+ * Usage: potbench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define LEFT_POTENT_RANGE 2000
+#define RIGHT_POTENT_RANGE 1720
+#define POTENT_ONE 65536
+#define POTENT_TOLERANCE_Q16 (POTENT_ONE / 10)
+#define POTENT_TOLERANCE_FLOAT 0.10f
+
+static volatile int lPotent;
+static volatile int rPotent;
+
+__attribute__((noinline)) static float getLeftPotent() {
+    return (float)lPotent / 2000;
+}
+__attribute__((noinline)) static float getRightPotent() {
+    return (float)rPotent / 1720;
+}
+__attribute__((noinline)) static int getLeftPotentQ16() {
+    return (lPotent << 16) / LEFT_POTENT_RANGE;
+}
+__attribute__((noinline)) static int getRightPotentQ16() {
+    return (rPotent << 16) / RIGHT_POTENT_RANGE;
+}
+
+// Same comparisons as the old handleUpperLift(), four getter calls per tick
+static int floatTick() {
+    if (getLeftPotent() - getRightPotent() > POTENT_TOLERANCE_FLOAT)
+        return 1;
+    if (getRightPotent() - getLeftPotent() > POTENT_TOLERANCE_FLOAT)
+        return -1;
+    return 0;
+}
+
+static int fixedTick() {
+    int left = getLeftPotentQ16();
+    int right = getRightPotentQ16();
+    if (left - right > POTENT_TOLERANCE_Q16)
+        return 1;
+    if (right - left > POTENT_TOLERANCE_Q16)
+        return -1;
+    return 0;
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double run(int (*tick)(), long iterations, long *checksum) {
+    double start = now();
+    for (long i = 0; i < iterations; i++) {
+        lPotent = i & 2047;
+        rPotent = (i * 7) & 2047;
+        *checksum += tick();
+    }
+    return (now() - start) * 1e9 / iterations;
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 50000000;
+    long floatSum = 0;
+    long fixedSum = 0;
+
+    double floatNs = run(floatTick, iterations, &floatSum);
+    double fixedNs = run(fixedTick, iterations, &fixedSum);
+
+    printf("float: %.2f ns/tick\n", floatNs);
+    printf("q16:   %.2f ns/tick\n", fixedNs);
+    printf("speedup: %.2fx\n", floatNs / fixedNs);
+    // The two paths round differently right at the tolerance, so a few decisions may differ
+    printf("decision checksum: float %ld, q16 %ld\n", floatSum, fixedSum);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/** @file telemetry.c
+ * @brief Host decoder of the robot's binary telemetry stream
+ *
+ * Reads a capture of the telemetry stream, such as the output of the PROS terminal saved to a
+ * file, and prints one CSV row per record. Frames that don't decode to a whole record, such as
+ * text from printf() mixed into the stream, are skipped and counted on stderr. The format is
+ * described in include/telemetry.h.
+ *
+ * Potentiometer values are printed in potent units, 1.000 being the top of the lift.
+ *
+ * Usage: telemetry < capture > telemetry.csv
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Must match include/telemetry.h
+#define TELEMETRY_VALUES 3
+#define TELEMETRY_RECORD_BYTES (8 + 4 * TELEMETRY_VALUES)
+#define TELEMETRY_DROPPED 0
+#define TELEMETRY_POTENTS 1
+#define POTENT_ONE 65536
+
+// Longest frame worth decoding; anything longer is not a record
+#define MAX_FRAME 64
+
+static long getLong(const unsigned char *bytes) {
+    return (long)(int)(bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (unsigned)bytes[3] << 24);
+}
+
+// Undoes the byte stuffing, returning the decoded length, or -1 if the frame is malformed
+static int decodeFrame(const unsigned char *frame, int length, unsigned char *bytes) {
+    int out = 0;
+    int i = 0;
+    while (i < length) {
+        int code = frame[i++];
+        if (code == 0 || i + code - 1 > length)
+            return -1;
+        for (int j = 1; j < code; j++)
+            bytes[out++] = frame[i++];
+        if (i < length)
+            bytes[out++] = 0;
+    }
+    return out;
+}
+
+static void printPotent(long q16) {
+    long milli = q16 * 1000 / POTENT_ONE;
+    printf(",%s%ld.%03ld", milli < 0 ? "-" : "", (milli < 0 ? -milli : milli) / 1000,
+        (milli < 0 ? -milli : milli) % 1000);
+}
+
+static void printRecord(const unsigned char *bytes) {
+    long time = getLong(&bytes[4]);
+    long values[TELEMETRY_VALUES];
+    for (int i = 0; i < TELEMETRY_VALUES; i++)
+        values[i] = getLong(&bytes[8 + 4 * i]);
+
+    switch (bytes[0]) {
+    case TELEMETRY_DROPPED:
+        printf("%ld,dropped,%ld,,\n", time, values[0]);
+        break;
+    case TELEMETRY_POTENTS:
+        printf("%ld,potents", time);
+        for (int i = 0; i < TELEMETRY_VALUES; i++)
+            printPotent(values[i]);
+        printf("\n");
+        break;
+    default:
+        printf("%ld,%d,%ld,%ld,%ld\n", time, bytes[0], values[0], values[1], values[2]);
+        break;
+    }
+}
+
+int main() {
+    unsigned char frame[MAX_FRAME];
+    unsigned char bytes[MAX_FRAME];
+    int length = 0;
+    bool overflowed = false;
+    long records = 0;
+    long skipped = 0;
+    int c;
+
+    printf("time,record,value1,value2,value3\n");
+    while ((c = getchar()) != EOF) {
+        if (c != 0) {
+            if (length < MAX_FRAME)
+                frame[length++] = c;
+            else
+                overflowed = true;
+            continue;
+        }
+        if (length > 0) {
+            if (!overflowed && decodeFrame(frame, length, bytes) == TELEMETRY_RECORD_BYTES) {
+                printRecord(bytes);
+                records++;
+            } else {
+                skipped++;
+            }
+        }
+        length = 0;
+        overflowed = false;
+    }
+    fprintf(stderr, "%ld records, %ld frames skipped\n", records, skipped);
+    return 0;
+}